@@ -4,68 +4,42 @@
 
 calendar::calendar()
 {
- second = 0;
- minute = 0;
- hour = 0;
- day = 0;
- season = SPRING;
- year = 0;
+ turn_number = 0;
+ light_minute = -1;
+ light_level = 0;
 }
 
 calendar::calendar(const calendar &copy)
 {
- second = copy.second;
- minute = copy.minute;
- hour   = copy.hour;
- day    = copy.day;
- season = copy.season;
- year   = copy.year;
+ turn_number = copy.turn_number;
+ light_minute = copy.light_minute;
+ light_level = copy.light_level;
 }
 
 calendar::calendar(int Minute, int Hour, int Day, season_type Season, int Year)
 {
- second = 0;
- minute = Minute;
- hour = Hour;
- day = Day;
- season = Season;
- year = Year;
+ turn_number = MINUTES(Minute) + HOURS(Hour) + DAYS(Day) +
+               DAYS(int(Season) * DAYS_IN_SEASON) +
+               DAYS(Year * 4 * DAYS_IN_SEASON);
+ light_minute = -1;
+ light_level = 0;
 }
 
 calendar::calendar(int turn)
 {
- int minutes = int(turn / 10);
- int hours = minutes / 60;
- int days = hours / 24;
- int seasons = days / DAYS_IN_SEASON;
- second = 6 * (turn % 10);
- minute = minutes % 60;
- hour = hours % 24;
- day = 1 + days % DAYS_IN_SEASON;
- season = season_type(seasons % 4);
- year = seasons / 4;
+ turn_number = turn;
+ light_minute = -1;
+ light_level = 0;
 }
 
 int calendar::get_turn()
 {
- int ret = second / 6;
- ret += minute * 10;
- ret += hour * 600;
- ret += day * 14400;
- ret += int(season) * 14400 * DAYS_IN_SEASON;
- ret += year * 14400 * 4 * DAYS_IN_SEASON;
- return ret;
+ return turn_number;
 }
 
 calendar::operator int() const
 {
- int ret = second / 6;
- ret += minute * 10;
- ret += hour * 600;
- ret += day * 14400;
- ret += int(season) * 14400 * DAYS_IN_SEASON;
- ret += year * 14400 * 4 * DAYS_IN_SEASON;
- return ret;
+ return turn_number;
 }
 
 calendar& calendar::operator =(calendar &rhs)
@@ -73,76 +47,40 @@ calendar& calendar::operator =(calendar &rhs)
  if (this == &rhs)
   return *this;
 
- second = rhs.second;
- minute = rhs.minute;
- hour = rhs.hour;
- day = rhs.day;
- season = rhs.season;
- year = rhs.year;
+ turn_number = rhs.turn_number;
+ light_minute = rhs.light_minute;
+ light_level = rhs.light_level;
 
  return *this;
 }
 
 calendar& calendar::operator =(int rhs)
 {
- int minutes = int(rhs / 10);
- int hours = minutes / 60;
- int days = hours / 24;
- int seasons = days / DAYS_IN_SEASON;
- second = 6 * (rhs % 10);
- minute = minutes % 60;
- hour = hours % 24;
- day = days % DAYS_IN_SEASON;
- season = season_type(seasons % 4);
- year = seasons / 4;
+ turn_number = rhs;
  return *this;
 }
  
 calendar& calendar::operator -=(calendar &rhs)
 {
- second -= rhs.second;
- minute -= rhs.minute;
- hour   -= rhs.hour;
- day    -= rhs.day;
- int tmpseason = int(season) - int(rhs.season);
- while (tmpseason < 0) {
-  year--;
-  tmpseason += 4;
- }
- season = season_type(tmpseason);
- year -= rhs.year;
- standardize();
+ turn_number -= rhs.turn_number;
  return *this;
 }
 
 calendar& calendar::operator -=(int rhs)
 {
- calendar tmp(rhs);
- *this -= tmp;
+ turn_number -= rhs;
  return *this;
 }
 
 calendar& calendar::operator +=(calendar &rhs)
 {
- second += rhs.second;
- minute += rhs.minute;
- hour   += rhs.hour;
- day    += rhs.day;
- int tmpseason = int(season) + int(rhs.season);
- while (tmpseason >= 4) {
-  year++;
-  tmpseason -= 4;
- }
- season = season_type(tmpseason);
- year += rhs.year;
- standardize();
+ turn_number += rhs.turn_number;
  return *this;
 }
 
 calendar& calendar::operator +=(int rhs)
 {
- second += rhs * 6;
- standardize();
+ turn_number += rhs;
  return *this;
 }
 
@@ -176,47 +114,47 @@ calendar calendar::operator +(int rhs)
 
 void calendar::increment()
 {
- second += 6;
- if (second >= 60)
-  standardize();
+ turn_number++;
 }
 
-void calendar::standardize()
+int calendar::second()
 {
- if (second >= 60) {
-  minute += second / 60;
-  second %= 60;
- }
- if (minute >= 60) {
-  hour += minute / 60;
-  minute %= 60;
- }
- if (hour >= 24) {
-  day += hour / 24;
-  hour %= 24;
- }
- int tmpseason = int(season);
- if (day >= DAYS_IN_SEASON) {
-  tmpseason += day / DAYS_IN_SEASON;
-  day %= DAYS_IN_SEASON;
- }
- if (tmpseason >= 4) {
-  year += tmpseason / 4;
-  tmpseason %= 4;
- }
- season = season_type(tmpseason);
+ return 6 * (turn_number % 10);
+}
+
+int calendar::minute()
+{
+ return (turn_number / MINUTES(1)) % 60;
+}
+
+int calendar::hour()
+{
+ return (turn_number / HOURS(1)) % 24;
+}
+
+int calendar::day()
+{
+ return (turn_number / DAYS(1)) % DAYS_IN_SEASON;
+}
+
+season_type calendar::season()
+{
+ return season_type((turn_number / DAYS(DAYS_IN_SEASON)) % 4);
+}
+
+int calendar::year()
+{
+ return turn_number / DAYS(4 * DAYS_IN_SEASON);
 }
 
 int calendar::minutes_past_midnight()
 {
- //debugmsg("minute: %d  hour: %d");
- int ret = minute + hour * 60;
- return ret;
+ return (turn_number / MINUTES(1)) % (24 * 60);
 }
 
 moon_phase calendar::moon()
 {
- int phase = day / (DAYS_IN_SEASON / 4);
+ int phase = day() / (DAYS_IN_SEASON / 4);
  //phase %= 4;   Redundant?
  if (phase = 3)
   return MOON_HALF;
@@ -226,9 +164,8 @@ moon_phase calendar::moon()
 
 calendar calendar::sunrise()
 {
- calendar ret;
  int start_hour = 0, end_hour = 0;
- switch (season) {
+ switch (season()) {
   case SPRING:
    start_hour = SUNRISE_SOLSTICE;
    end_hour   = SUNRISE_SUMMER;
@@ -246,21 +183,18 @@ calendar calendar::sunrise()
    end_hour   = SUNRISE_SOLSTICE;
    break;
  }
- double percent = double(double(day) / DAYS_IN_SEASON);
+ double percent = double(double(day()) / DAYS_IN_SEASON);
  double time = double(start_hour) * (1.- percent) + double(end_hour) * percent;
 
- ret.hour = int(time);
+ int hours = int(time);
  time -= int(time);
- ret.minute = int(time * 60);
-
- return ret;
+ return calendar(int(time * 60), hours, 0, SPRING, 0);
 }
 
 calendar calendar::sunset()
 {
- calendar ret;
  int start_hour = 0, end_hour = 0;
- switch (season) {
+ switch (season()) {
   case SPRING:
    start_hour = SUNSET_SOLSTICE;
    end_hour   = SUNSET_SUMMER;
@@ -278,14 +212,12 @@ calendar calendar::sunset()
    end_hour   = SUNSET_SOLSTICE;
    break;
  }
- double percent = double(double(day) / DAYS_IN_SEASON);
+ double percent = double(double(day()) / DAYS_IN_SEASON);
  double time = double(start_hour) * (1.- percent) + double(end_hour) * percent;
 
- ret.hour = int(time);
+ int hours = int(time);
  time -= int(time);
- ret.minute = int(time * 60);
-
- return ret;
+ return calendar(int(time * 60), hours, 0, SPRING, 0);
 }
 
 bool calendar::is_night()
@@ -300,6 +232,16 @@ bool calendar::is_night()
 }
 
 int calendar::sunlight()
+{
+// Light only changes by the minute, and we're asked every turn
+ if (light_minute == turn_number / MINUTES(1))
+  return light_level;
+ light_minute = turn_number / MINUTES(1);
+ light_level = calc_sunlight();
+ return light_level;
+}
+
+int calendar::calc_sunlight()
 {
  calendar sunrise_time = sunrise(), sunset_time = sunset();
 
@@ -331,6 +273,7 @@ int calendar::sunlight()
 
 std::string calendar::print_time(bool twentyfour)
 {
+ int hour = this->hour(), minute = this->minute();
  std::stringstream ret;
  if (twentyfour) {
   ret << hour << ":";
@@ -37,15 +37,6 @@ MOON_FULL
 class calendar
 {
  public:
-// The basic data; note that "second" should always be a multiple of 6
-  int second;
-  int minute;
-  int hour;
-  int day;
-  season_type season;
-  int year;
-// End data
-
   calendar();
   calendar(const calendar &copy);
   calendar(int Minute, int Hour, int Day, season_type Season, int Year);
@@ -65,7 +56,14 @@ class calendar
 
   void increment();   // Add one turn / 6 seconds
 
-  void standardize(); // Ensure minutes <= 59, hour <= 23, etc.
+// The time of day and date, worked out from the turn; "second" is always a
+//  multiple of 6
+  int second();
+  int minute();
+  int hour();
+  int day();
+  season_type season();
+  int year();
 
 // Sunlight and day/night calcuations
   int minutes_past_midnight(); // Useful for sunrise/set calculations
@@ -77,4 +75,9 @@ class calendar
 
 // Print-friendly stuff
   std::string print_time(bool twentyfour = false);
+
+ private:
+  int calc_sunlight();
+  int turn_number;
+  int light_minute, light_level; // sunlight() as of minute light_minute
 };
@@ -249,32 +249,30 @@ void computer::activate_function(game *g, computer_action action)
    print_line("Doors opened.");
    break;
 
-  case COMPACT_SAMPLE:
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_sewage_pump) {
-      for (int x1 = x - 1; x1 <= x + 1; x1++) {
-       for (int y1 = y - 1; y1 <= y + 1; y1++ ) {
-        if (g->m.ter(x1, y1) == t_counter) {
-         bool found_item = false;
-         for (int i = 0; i < g->m.i_at(x1, y1).size(); i++) {
-          item *it = &(g->m.i_at(x1, y1)[i]);
-          if (it->is_container() && it->contents.empty()) {
-           it->put_in( item(g->itypes[itm_sewage], g->turn) );
-           found_item = true;
-          }
-         }
-         if (!found_item) {
-          item sewage(g->itypes[itm_sewage], g->turn);
-          g->m.add_item(x1, y1, sewage);
-         }
+  case COMPACT_SAMPLE: {
+   std::vector<point> pumps = g->m.find_terrain(t_sewage_pump);
+   for (int n = 0; n < pumps.size(); n++) {
+    int x = pumps[n].x, y = pumps[n].y;
+    for (int x1 = x - 1; x1 <= x + 1; x1++) {
+     for (int y1 = y - 1; y1 <= y + 1; y1++ ) {
+      if (g->m.ter(x1, y1) == t_counter) {
+       bool found_item = false;
+       for (int i = 0; i < g->m.i_at(x1, y1).size(); i++) {
+        item *it = &(g->m.i_at(x1, y1)[i]);
+        if (it->is_container() && it->contents.empty()) {
+         it->put_in( item(g->itypes[itm_sewage], g->turn) );
+         found_item = true;
         }
        }
+       if (!found_item) {
+        item sewage(g->itypes[itm_sewage], g->turn);
+        g->m.add_item(x1, y1, sewage);
+       }
       }
      }
     }
    }
-   break;
+  } break;
 
   case COMPACT_RELEASE:
    g->sound(g->u.posx, g->u.posy, 40, "An alarm sounds!");
@@ -284,23 +282,39 @@ void computer::activate_function(game *g, computer_action action)
    break;
 
   case COMPACT_TERMINATE:
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     int mondex = g->mon_at(x, y);
-     if (mondex != -1 &&
-         ((g->m.ter(x, y - 1) == t_reinforced_glass_h &&
-           g->m.ter(x, y + 1) == t_wall_h) ||
-          (g->m.ter(x, y + 1) == t_reinforced_glass_h &&
-           g->m.ter(x, y - 1) == t_wall_h)))
-      g->kill_mon(mondex);
-    }
+// Backwards, since kill_mon() erases from z
+   for (int i = g->z.size() - 1; i >= 0; i--) {
+    if (i >= g->z.size())
+     continue;	// A death took more than one monster with it
+    int x = g->z[i].posx, y = g->z[i].posy;
+    if ((g->m.ter(x, y - 1) == t_reinforced_glass_h &&
+         g->m.ter(x, y + 1) == t_wall_h) ||
+        (g->m.ter(x, y + 1) == t_reinforced_glass_h &&
+         g->m.ter(x, y - 1) == t_wall_h))
+     g->kill_mon(i);
    }
    print_line("Subjects terminated.");
    break;
 
-  case COMPACT_PORTAL:
-   for (int i = 0; i < SEEX * MAPSIZE; i++) {
-    for (int j = 0; j < SEEY * MAPSIZE; j++) {
+  case COMPACT_PORTAL: {
+// Portals open where four towers stand within 2 squares, so only the squares
+// near a tower need checking
+   std::vector<point> towers = g->m.find_terrain(t_radio_tower);
+   if (towers.empty())
+    break;
+   int x1 = towers[0].x, y1 = towers[0].y, x2 = x1, y2 = y1;
+   for (int i = 1; i < towers.size(); i++) {
+    x1 = (towers[i].x < x1 ? towers[i].x : x1);
+    y1 = (towers[i].y < y1 ? towers[i].y : y1);
+    x2 = (towers[i].x > x2 ? towers[i].x : x2);
+    y2 = (towers[i].y > y2 ? towers[i].y : y2);
+   }
+   x1 = (x1 - 2 < 0 ? 0 : x1 - 2);
+   y1 = (y1 - 2 < 0 ? 0 : y1 - 2);
+   x2 = (x2 + 2 >= SEEX * MAPSIZE ? SEEX * MAPSIZE - 1 : x2 + 2);
+   y2 = (y2 + 2 >= SEEY * MAPSIZE ? SEEY * MAPSIZE - 1 : y2 + 2);
+   for (int i = x1; i <= x2; i++) {
+    for (int j = y1; j <= y2; j++) {
      int numtowers = 0;
      for (int xt = i - 2; xt <= i + 2; xt++) {
       for (int yt = j - 2; yt <= j + 2; yt++) {
@@ -316,7 +330,7 @@ void computer::activate_function(game *g, computer_action action)
      }
     }
    }
-   break;
+  } break;
 
   case COMPACT_CASCADE: {
    if (!query_bool("WARNING: Resonance cascade carries severe risk!  Continue?"))
@@ -476,15 +490,12 @@ void computer::activate_function(game *g, computer_action action)
     print_line("%d OTHERS FOUND...");
   } break;
 
-  case COMPACT_ELEVATOR_ON:
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_elevator_control_off)
-      g->m.ter(x, y) = t_elevator_control;
-    }
-   }
+  case COMPACT_ELEVATOR_ON: {
+   std::vector<point> controls = g->m.find_terrain(t_elevator_control_off);
+   for (int i = 0; i < controls.size(); i++)
+    g->m.ter_set(controls[i].x, controls[i].y, t_elevator_control);
    print_line("Elevator activated.");
-   break;
+  } break;
 
   case COMPACT_AMIGARA_LOG: // TODO: This is static, move to data file?
    print_line("NEPower Mine(%d:%d) Log", g->levx, g->levy);
@@ -654,14 +665,11 @@ void computer::activate_failure(game *g, computer_failure fail)
   case COMPFAIL_NULL:
    break;	// Do nothing.  Why was this even called >:|
 
-  case COMPFAIL_SHUTDOWN:
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.has_flag(console, x, y))
-      g->m.ter(x, y) = t_console_broken;
-    }
-   }
-   break;
+  case COMPFAIL_SHUTDOWN: {
+   std::vector<point> consoles = g->m.find_terrain(console);
+   for (int i = 0; i < consoles.size(); i++)
+    g->m.ter_set(consoles[i].x, consoles[i].y, t_console_broken);
+  } break;
 
   case COMPFAIL_ALARM:
    g->sound(g->u.posx, g->u.posy, 60, "An alarm sounds!");
@@ -710,47 +718,42 @@ void computer::activate_failure(game *g, computer_failure fail)
    g->u.hurtall(rng(1, 10));
    break;
 
-  case COMPFAIL_PUMP_EXPLODE:
+  case COMPFAIL_PUMP_EXPLODE: {
    g->add_msg("The pump explodes!");
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_sewage_pump) {
-      g->m.ter(x, y) = t_rubble;
-      g->explosion(x, y, 10, 0, false);
-     }
-    }
+   std::vector<point> pumps = g->m.find_terrain(t_sewage_pump);
+   for (int i = 0; i < pumps.size(); i++) {
+    int x = pumps[i].x, y = pumps[i].y;
+    g->m.ter_set(x, y, t_rubble);
+    g->explosion(x, y, 10, 0, false);
    }
-   break;
+  } break;
 
-  case COMPFAIL_PUMP_LEAK:
+  case COMPFAIL_PUMP_LEAK: {
    g->add_msg("Sewage leaks!");
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_sewage_pump) {
-      point p(x, y);
-      int leak_size = rng(4, 10);
-      for (int i = 0; i < leak_size; i++) {
-       std::vector<point> next_move;
-       if (g->m.move_cost(p.x, p.y - 1) > 0)
-        next_move.push_back( point(p.x, p.y - 1) );
-       if (g->m.move_cost(p.x + 1, p.y) > 0)
-        next_move.push_back( point(p.x + 1, p.y) );
-       if (g->m.move_cost(p.x, p.y + 1) > 0)
-        next_move.push_back( point(p.x, p.y + 1) );
-       if (g->m.move_cost(p.x - 1, p.y) > 0)
-        next_move.push_back( point(p.x - 1, p.y) );
-
-       if (next_move.empty())
-        i = leak_size;
-       else {
-        p = next_move[rng(0, next_move.size() - 1)];
-        g->m.ter(p.x, p.y) = t_sewage;
-       }
-      }
+   std::vector<point> pumps = g->m.find_terrain(t_sewage_pump);
+   for (int n = 0; n < pumps.size(); n++) {
+    point p = pumps[n];
+    int leak_size = rng(4, 10);
+    for (int i = 0; i < leak_size; i++) {
+     std::vector<point> next_move;
+     if (g->m.move_cost(p.x, p.y - 1) > 0)
+      next_move.push_back( point(p.x, p.y - 1) );
+     if (g->m.move_cost(p.x + 1, p.y) > 0)
+      next_move.push_back( point(p.x + 1, p.y) );
+     if (g->m.move_cost(p.x, p.y + 1) > 0)
+      next_move.push_back( point(p.x, p.y + 1) );
+     if (g->m.move_cost(p.x - 1, p.y) > 0)
+      next_move.push_back( point(p.x - 1, p.y) );
+
+     if (next_move.empty())
+      i = leak_size;
+     else {
+      p = next_move[rng(0, next_move.size() - 1)];
+      g->m.ter_set(p.x, p.y, t_sewage);
      }
     }
    }
-   break;
+  } break;
 
   case COMPFAIL_AMIGARA:
    g->add_event(EVENT_AMIGARA, int(g->turn) + 5, 0, 0, 0);
@@ -522,7 +522,7 @@ void game::complete_construction()
  
 // Make the terrain change
  int terx = u.activity.placement.x, tery = u.activity.placement.y;
- m.ter(terx, tery) = stage.terrain;
+ m.ter_set(terx, tery, stage.terrain);
  construct effects;
  (effects.*built.done)(this, point(terx, tery));
 
@@ -68,18 +68,20 @@ void event::actualize(game *g)
    int num_horrors = rng(3, 5);
    int faultx = -1, faulty = -1;
    bool horizontal;
-   for (int x = 0; x < SEEX * MAPSIZE && faultx == -1; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE && faulty == -1; y++) {
-     if (g->m.ter(x, y) == t_fault) {
-      faultx = x;
-      faulty = y;
-      if (g->m.ter(x - 1, y) == t_fault || g->m.ter(x + 1, y) == t_fault)
-       horizontal = true;
-      else
-       horizontal = false;
-     }
+   std::vector<point> faults = g->m.find_terrain(t_fault);
+   for (int i = 0; i < faults.size(); i++) {
+// Use the first in scan order, leftmost column first
+    if (faultx == -1 || faults[i].x < faultx ||
+        (faults[i].x == faultx && faults[i].y < faulty)) {
+     faultx = faults[i].x;
+     faulty = faults[i].y;
     }
    }
+   if (g->m.ter(faultx - 1, faulty) == t_fault ||
+       g->m.ter(faultx + 1, faulty) == t_fault)
+    horizontal = true;
+   else
+    horizontal = false;
    monster horror(g->mtypes[mon_amigara_horror]);
    for (int i = 0; i < num_horrors; i++) {
     int tries = 0;
@@ -107,83 +109,74 @@ void event::actualize(game *g)
    }
   } break;
 
-  case EVENT_ROOTS_DIE:
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_root_wall && one_in(3))
-      g->m.ter(x, y) = t_underbrush;
-    }
+  case EVENT_ROOTS_DIE: {
+   std::vector<point> roots = g->m.find_terrain(t_root_wall);
+   for (int i = 0; i < roots.size(); i++) {
+    if (one_in(3))
+     g->m.ter_set(roots[i].x, roots[i].y, t_underbrush);
    }
-   break;
+  } break;
 
   case EVENT_TEMPLE_OPEN: {
    bool saw_grate = false;
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++) {
-     if (g->m.ter(x, y) == t_grate) {
-      g->m.ter(x, y) = t_stairs_down;
-      int j;
-      if (!saw_grate && g->u_see(x, y, j))
-       saw_grate = true;
-     }
-    }
+   std::vector<point> grates = g->m.find_terrain(t_grate);
+   for (int i = 0; i < grates.size(); i++) {
+    int x = grates[i].x, y = grates[i].y;
+    g->m.ter_set(x, y, t_stairs_down);
+    int j;
+    if (!saw_grate && g->u_see(x, y, j))
+     saw_grate = true;
    }
    if (saw_grate)
     g->add_msg("The nearby grates open to reveal a staircase!");
   } break;
 
   case EVENT_TEMPLE_FLOOD: {
-   bool flooded = false;
-   map copy;
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++)
-     copy.ter(x, y) = g->m.ter(x, y);
-   }
+// Water isn't indexed, since it can be anywhere, so this still looks at every
+// square; but only the squares which change are written back
+   std::vector<point> deepen, flood;
    for (int x = 0; x < SEEX * MAPSIZE; x++) {
     for (int y = 0; y < SEEY * MAPSIZE; y++) {
      if (g->m.ter(x, y) == t_water_sh) {
-      bool deepen = false;
-      for (int wx = x - 1;  wx <= x + 1 && !deepen; wx++) {
-       for (int wy = y - 1;  wy <= y + 1 && !deepen; wy++) {
+      bool deep = false;
+      for (int wx = x - 1;  wx <= x + 1 && !deep; wx++) {
+       for (int wy = y - 1;  wy <= y + 1 && !deep; wy++) {
         if (g->m.ter(wx, wy) == t_water_dp)
-         deepen = true;
+         deep = true;
        }
       }
-      if (deepen) {
-       copy.ter(x, y) = t_water_dp;
-       flooded = true;
-      }
+      if (deep)
+       deepen.push_back(point(x, y));
      } else if (g->m.ter(x, y) == t_rock_floor) {
-      bool flood = false;
-      for (int wx = x - 1;  wx <= x + 1 && !flood; wx++) {
-       for (int wy = y - 1;  wy <= y + 1 && !flood; wy++) {
+      bool wet = false;
+      for (int wx = x - 1;  wx <= x + 1 && !wet; wx++) {
+       for (int wy = y - 1;  wy <= y + 1 && !wet; wy++) {
         if (g->m.ter(wx, wy) == t_water_dp || g->m.ter(wx, wy) == t_water_sh)
-         flood = true;
+         wet = true;
        }
       }
-      if (flood) {
-       copy.ter(x, y) = t_water_sh;
-       flooded = true;
-      }
+      if (wet)
+       flood.push_back(point(x, y));
      }
     }
    }
-   if (!flooded)
+   if (deepen.empty() && flood.empty())
     return; // We finished flooding the entire chamber!
 // Check if we should print a message
-   if (copy.ter(g->u.posx, g->u.posy) != g->m.ter(g->u.posx, g->u.posy)) {
-    if (copy.ter(g->u.posx, g->u.posy) == t_water_sh)
+   for (int i = 0; i < flood.size(); i++) {
+    if (flood[i].x == g->u.posx && flood[i].y == g->u.posy)
      g->add_msg("Water quickly floods up to your knees.");
-    else { // Must be deep water!
+   }
+   for (int i = 0; i < deepen.size(); i++) {
+    if (deepen[i].x == g->u.posx && deepen[i].y == g->u.posy) {
      g->add_msg("Water fills nearly to the ceiling!");
      g->plswim(g->u.posx, g->u.posy);
     }
    }
-// copy is filled with correct tiles; now copy them back to g->m
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE; y++)
-     g->m.ter(x, y) = copy.ter(x, y);
-   }
+   for (int i = 0; i < deepen.size(); i++)
+    g->m.ter_set(deepen[i].x, deepen[i].y, t_water_dp);
+   for (int i = 0; i < flood.size(); i++)
+    g->m.ter_set(flood[i].x, flood[i].y, t_water_sh);
    g->add_event(EVENT_TEMPLE_FLOOD, int(g->turn) + rng(2, 3));
   } break;
 
@@ -254,3 +247,114 @@ void event::per_turn(game *g)
    break; // Nothing happens for other events
  }
 }
+
+bool event::ticks()
+{
+ switch (type) {
+  case EVENT_WANTED:
+  case EVENT_SPAWN_WYRMS:
+  case EVENT_AMIGARA:
+  case EVENT_TEMPLE_OPEN:
+   return true;
+  default:
+   return false;
+ }
+}
+
+event_wheel::event_wheel()
+{
+ now = 0;
+ count = 0;
+}
+
+void event_wheel::reset(int turn)
+{
+ for (int i = 0; i < EVENT_SLOTS; i++) {
+  slots[i].clear();
+  blocks[i].clear();
+ }
+ later.clear();
+ ticking.clear();
+ now = turn;
+ count = 0;
+}
+
+void event_wheel::add(event ev)
+{
+ if (ev.ticks())
+  ticking.push_back(ev);
+ else {
+  file(ev);
+  count++;
+ }
+}
+
+void event_wheel::file(event ev)
+{
+ int t = (ev.turn > now ? ev.turn : now + 1);	// Overdue goes off next turn
+ if (t - now <= EVENT_SLOTS)
+  slots[t % EVENT_SLOTS].push_back(ev);
+ else if (t / EVENT_SLOTS - now / EVENT_SLOTS < EVENT_SLOTS - 1)
+  blocks[(t / EVENT_SLOTS) % EVENT_SLOTS].push_back(ev);
+ else
+  later.push_back(ev);
+}
+
+void event_wheel::advance(int turn, std::vector<event> &due)
+{
+ while (now < turn) {
+  now++;
+  if (now % EVENT_SLOTS == 0) {
+// A new block begins; spread it over the slots, and see what in later is now
+//  close enough for a block
+   std::vector<event> &block = blocks[(now / EVENT_SLOTS) % EVENT_SLOTS];
+   for (int i = 0; i < block.size(); i++)
+    slots[block[i].turn % EVENT_SLOTS].push_back(block[i]);
+   block.clear();
+   std::vector<event> waiting;
+   waiting.swap(later);
+   now--;	// file() counts from the turn before
+   for (int i = 0; i < waiting.size(); i++)
+    file(waiting[i]);
+   now++;
+  }
+  std::vector<event> &slot = slots[now % EVENT_SLOTS];
+  for (int i = 0; i < slot.size(); i++)
+   due.push_back(slot[i]);
+  count -= slot.size();
+  slot.clear();
+ }
+ for (int i = 0; i < ticking.size(); i++) {
+  if (ticking[i].turn <= turn) {
+   due.push_back(ticking[i]);
+   ticking.erase(ticking.begin() + i);
+   i--;
+  }
+ }
+}
+
+bool event_wheel::has(event_type type)
+{
+ std::vector<event> pending = list();
+ for (int i = 0; i < pending.size(); i++) {
+  if (pending[i].type == type)
+   return true;
+ }
+ return false;
+}
+
+int event_wheel::size()
+{
+ return count + ticking.size();
+}
+
+std::vector<event> event_wheel::list()
+{
+ std::vector<event> ret = ticking;
+ for (int i = 0; i < EVENT_SLOTS; i++) {
+  ret.insert(ret.end(), slots[i].begin(), slots[i].end());
+  ret.insert(ret.end(), blocks[i].begin(), blocks[i].end());
+ }
+ ret.insert(ret.end(), later.begin(), later.end());
+ return ret;
+}
@@ -3,6 +3,7 @@
 
 #include "faction.h"
 #include "line.h"
+#include <vector>
 
 class game;
 
@@ -17,6 +18,11 @@ enum event_type {
  EVENT_TEMPLE_OPEN,
  EVENT_TEMPLE_FLOOD,
  EVENT_TEMPLE_SPAWN,
+// The game's own periodic work, filed in game::tasks; see game::do_turn()
+ TASK_UPKEEP,		// Hunger, thirst &c., every 5 minutes
+ TASK_HALF_HOUR,	// Pain, healing and the autosave
+ TASK_WEATHER,		// nextweather has come round
+ TASK_SPAWN,		// We may have stayed put long enough for a spawn
  NUM_EVENT_TYPES
 };
 
@@ -44,6 +50,35 @@ struct event {
 
  void actualize(game *g); // When the time runs out
  void per_turn(game *g);  // Every turn
+ bool ticks();            // Does per_turn() do anything for this type?
+};
+
+// Pending events, filed by the turn they're due so each turn only looks at the
+// ones due then.  The next EVENT_SLOTS turns get a slot each; events further
+// off wait in blocks of EVENT_SLOTS turns, or in later if there's no block for
+// them yet, and move down as their time comes round.  Events that do something
+// every turn while they wait are kept in ticking instead.
+#define EVENT_SLOTS 64
+
+class event_wheel
+{
+ public:
+  event_wheel();
+  void reset(int turn);   // Drop everything; turn is the current turn
+  void add(event ev);
+  void advance(int turn, std::vector<event> &due); // Pop all due by turn
+  bool has(event_type type);
+  int size();
+  std::vector<event> list(); // Everything pending, for saving
+
+  std::vector<event> ticking;
+ private:
+  void file(event ev);
+  std::vector<event> slots[EVENT_SLOTS];
+  std::vector<event> blocks[EVENT_SLOTS];
+  std::vector<event> later;
+  int now;	// The last turn advance() reached
+  int count;	// Held in slots, blocks and later
 };
 
 #endif
@@ -1,46 +1,358 @@
 #include "rng.h"
 #include "map.h"
 #include "game.h"
+#include <atomic>
+#if FIELD_THREADS > 1
+#include <thread>
+#endif
 
 #define INBOUNDS(x, y) \
  (x >= 0 && x < SEEX * my_MAPSIZE && y >= 0 && y < SEEY * my_MAPSIZE)
 
 bool vector_has(std::vector <item> vec, itype_id type);
 
+// Smoke, tear gas, toxic gas and nuke gas, weakest to strongest
+static int gas_rank(field_id type)
+{
+ switch (type) {
+  case fd_smoke:	return 1;
+  case fd_tear_gas:	return 2;
+  case fd_toxic_gas:	return 3;
+  case fd_nuke_gas:	return 4;
+  default:		return 0;
+ }
+}
+
+// Fields advance a generation at a time.  A square's own field changes in
+// place, but anything it does to another square (gas drifting in or clearing
+// scent, fire spreading or feeding its neighbours, smoke, terrain burning away
+// or going off) is queued in its submap's field_changes and only applied by
+// apply_field_changes() once every square has had its turn.  Whatever a
+// field looks at elsewhere comes from the snapshot taken as the pass began:
+// prev_field() for fields, field_fuel for flammable items, and terrain,
+// which nothing changes until the queue is applied.  So no square acts on
+// what a neighbour did this pass.
+// That makes each submap a job of its own: it writes only its own squares and
+// queue, and reads nothing another job writes.  Each draws from its own
+// random stream, seeded by where and when it is, so the jobs are shared out
+// between FIELD_THREADS threads and come out the same whichever thread ran
+// them, in whatever order.  The queues are applied afterwards, submap by
+// submap in grid order, each in the order its changes were made, and a change
+// that lands on a square another has already changed sees the result.
+struct field_jobs {
+ std::vector<int> gridn;	// The submaps with fields
+ std::vector<char> found;	// What process_fields_in_submap() said of each
+ std::atomic<int> next;		// The first job nobody has taken yet
+ field_jobs() : next (0) {}
+};
+
 bool map::process_fields(game *g)
 {
  bool found_field = false;
- for (int x = 0; x < my_MAPSIZE; x++) {
-  for (int y = 0; y < my_MAPSIZE; y++) {
-   if (grid[x + y * my_MAPSIZE].field_count > 0)
-    found_field |= process_fields_in_submap(g, x + y * my_MAPSIZE);
+ if (int(g->turn) != field_turn) {
+  field_turn = int(g->turn);
+  field_pass = 0;
+ }
+ field_pass++;	// Catching up in loadn() may run us several times a turn
+ snapshot_fields();
+ field_jobs jobs;
+ int squares = 0;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  if (grid[n].field_count > 0) {
+   jobs.gridn.push_back(n);
+   squares += grid[n].field_count;
+// The jobs mustn't build these as they go; build the ones they'll read now
+   if (!outside_valid[n])
+    build_outside_mask(n);
+  }
+ }
+ if (!jobs.gridn.empty() && !tile_cache_valid)
+  build_tile_cache();
+ jobs.found.resize(jobs.gridn.size(), false);
+#if FIELD_THREADS > 1
+// Starting a thread costs about as much as fifteen squares of fields; give
+// each at least a submap's worth, so small passes stay on this one
+ int threads = FIELD_THREADS;
+ if (threads > squares / (SEEX * SEEY))
+  threads = squares / (SEEX * SEEY);
+ if (threads > jobs.gridn.size())
+  threads = jobs.gridn.size();
+ if (threads > std::thread::hardware_concurrency() &&
+     std::thread::hardware_concurrency() > 0)
+  threads = std::thread::hardware_concurrency();
+ std::vector<std::thread> pool;
+ for (int i = 1; i < threads; i++)
+  pool.push_back(std::thread(&map::run_field_jobs, this, g, &jobs));
+ run_field_jobs(g, &jobs);
+ for (int i = 0; i < pool.size(); i++)
+  pool[i].join();
+#else
+ run_field_jobs(g, &jobs);
+#endif
+ for (int i = 0; i < jobs.found.size(); i++)
+  found_field |= jobs.found[i];
+ apply_field_changes(g);
+// The kernels change their own fields in place, so touch whatever differs
+// from the snapshot; terrain changes went through ter_set() already
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  if (!field_snapped[n] && grid[n].field_count == 0)
+   continue;
+  int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+  for (int x = 0; x < SEEX; x++) {
+   for (int y = 0; y < SEEY; y++) {
+    field &cur = grid[n].fld[x][y];
+    field prev = prev_field(offx + x, offy + y);
+    if (cur.type != prev.type || cur.density != prev.density)
+     touch_tile(offx + x, offy + y);
+   }
   }
  }
  return found_field;
 }
 
+void map::run_field_jobs(game *g, field_jobs *jobs)
+{
+ int i;
+ while ((i = jobs->next++) < jobs->gridn.size()) {
+  int n = jobs->gridn[i];
+  rng_stream stream(field_seed(g->levx + n % my_MAPSIZE,
+                               g->levy + n / my_MAPSIZE, g->levz));
+  use_rng_stream(&stream);
+  jobs->found[i] = process_fields_in_submap(g, n);
+  use_rng_stream(NULL);	// Before stream goes out of scope
+ }
+}
+
+// Stands in for process_fields() over turns we skipped: every field ages and
+// rolls to thin out once per turn, but nothing burns or spreads
+void map::age_fields(game *g, int turns)
+{
+ if (int(g->turn) != field_turn) {
+  field_turn = int(g->turn);
+  field_pass = 0;
+ }
+ field_pass++;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  submap &sm = grid[n];
+  if (sm.field_count == 0)
+   continue;
+  rng_stream stream(field_seed(g->levx + n % my_MAPSIZE,
+                               g->levy + n / my_MAPSIZE, g->levz));
+  use_rng_stream(&stream);
+  for (int x = 0; x < SEEX; x++) {
+   for (int y = 0; y < SEEY; y++) {
+    field *cur = &(sm.fld[x][y]);
+    if (cur->type == fd_null || fieldlist[cur->type].halflife <= 0)
+     continue;
+    bool thinned = false;
+    for (int i = 0; i < turns && cur->density > 0; i++) {
+     cur->age++;
+     if (cur->age > 0 &&
+         dice(3, cur->age) > dice(3, fieldlist[cur->type].halflife)) {
+      cur->age = 0;
+      cur->density--;
+      thinned = true;
+     }
+    }
+    if (cur->density <= 0) {
+     sm.field_count--;
+     sm.fld[x][y] = field();
+    }
+    if (thinned)
+     touch_tile((n % my_MAPSIZE) * SEEX + x, (n / my_MAPSIZE) * SEEY + y);
+   }
+  }
+  use_rng_stream(NULL);
+ }
+}
+
+bool map::fields_near(int x, int y, int radius)
+{
+ int x1 = (x - radius) / SEEX, y1 = (y - radius) / SEEY,
+     x2 = (x + radius) / SEEX, y2 = (y + radius) / SEEY;
+ if (x1 < 0) x1 = 0;
+ if (y1 < 0) y1 = 0;
+ if (x2 >= my_MAPSIZE) x2 = my_MAPSIZE - 1;
+ if (y2 >= my_MAPSIZE) y2 = my_MAPSIZE - 1;
+ for (int i = x1; i <= x2; i++) {
+  for (int j = y1; j <= y2; j++) {
+   if (grid[i + j * my_MAPSIZE].field_count > 0)
+    return true;
+  }
+ }
+ return false;
+}
+
+unsigned long map::field_seed(int x, int y, int z)
+{
+ unsigned long seed = field_turn;
+ seed = seed * 2654435761UL + field_pass;
+ seed = seed * 2654435761UL + x;
+ seed = seed * 2654435761UL + y;
+ seed = seed * 2654435761UL + z;
+ return seed ^ (seed >> 16);
+}
+
+void map::snapshot_fields()
+{
+ if (field_prev.empty())
+  field_prev.resize(SEEX * MAPSIZE * SEEY * MAPSIZE);
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  field_snapped[n] = (grid[n].field_count > 0);
+  if (!field_snapped[n])
+   continue;
+  int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+  for (int x = 0; x < SEEX; x++) {
+   for (int y = 0; y < SEEY; y++) {
+    field &cur = grid[n].fld[x][y];
+    field_prev[(offx + x) * SEEY * MAPSIZE + offy + y] = cur;
+// Checked here, as debugmsg() mustn't be called from the jobs' threads
+    if (cur.density > 3 || cur.density < 1)
+     debugmsg("Whoooooa density of %d", cur.density);
+   }
+  }
+ }
+// Fires burn up their own items as they go, so note beforehand which of
+// their neighbours have fuel to spread to
+ field_fuel.clear();
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  if (!field_snapped[n])
+   continue;
+  int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+  for (int x = offx; x < offx + SEEX; x++) {
+   for (int y = offy; y < offy + SEEY; y++) {
+    if (grid[n].fld[x - offx][y - offy].type != fd_fire)
+     continue;
+    for (int i = x - 1; i <= x + 1; i++) {
+     for (int j = y - 1; j <= y + 1; j++) {
+      if (INBOUNDS(i, j) && flammable_items_at(i, j))
+       field_fuel.insert(i * SEEY * MAPSIZE + j);
+     }
+    }
+   }
+  }
+ }
+}
+
+void map::apply_field_changes(game *g)
+{
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  std::vector<field_change> &changes = field_changes[n];
+  for (int i = 0; i < changes.size(); i++)
+   apply_field_change(g, changes[i]);
+  changes.clear();
+ }
+}
+
+void map::apply_field_change(game *g, field_change &c)
+{
+ field &fd = field_at(c.x, c.y);
+ int part;
+ switch (c.kind) {
+
+  case FC_ADD:
+   add_field(g, c.x, c.y, c.type, c.density);
+   break;
+
+  case FC_GAS:
+   if (fd.type == c.type && fd.density < 3) {
+    fd.density++;
+    touch_tile(c.x, c.y);
+   } else if (fd.type != c.type && move_cost(c.x, c.y) > 0 &&
+              add_field(g, c.x, c.y, c.type, 1))
+    field_at(c.x, c.y).age = c.age;
+   else if (INBOUNDS(c.srcx, c.srcy)) {
+// The square filled up after we looked; give the gas back to its source
+    field &src = field_at(c.srcx, c.srcy);
+    if (src.type == c.type && src.density < 3) {
+     src.density++;
+     touch_tile(c.srcx, c.srcy);
+    } else if (src.is_null() && add_field(g, c.srcx, c.srcy, c.type, 1))
+     field_at(c.srcx, c.srcy).age = c.age;
+   }
+   break;
+
+  case FC_CONVERT:
+   if (gas_rank(fd.type) > 0 && gas_rank(fd.type) < gas_rank(c.type)) {
+    fd.type = c.type;
+    touch_tile(c.x, c.y);
+   }
+   break;
+
+  case FC_THICKEN:
+   if (fd.type == c.type && fd.density < 3) {
+    fd.density++;
+    if (c.age >= 0)
+     fd.age = c.age;
+    touch_tile(c.x, c.y);
+   }
+   break;
+
+  case FC_IGNITE:
+   if (fd.type == fd_smoke || fd.type == fd_web) {
+    fd = field(fd_fire, 1, 0);
+    touch_tile(c.x, c.y);
+   } else
+    add_field(g, c.x, c.y, fd_fire, 1);
+   break;
+
+  case FC_TERRAIN:
+   ter_set(c.x, c.y, c.ter);
+   break;
+
+  case FC_DETONATE:
+   if (has_flag(explodes, c.x, c.y)) {
+    ter_set(c.x, c.y, ter_id(int(ter(c.x, c.y)) + 1));
+    g->explosion(c.x, c.y, 40, 0, true);
+   }
+   break;
+
+  case FC_VEH_EXPLODE: {
+   vehicle *veh = &(veh_at(c.x, c.y, part));
+   if (veh->type != veh_null && veh->fuel > 0)
+    veh->explode(g, c.x, c.y);
+  } break;
+
+  case FC_SPAWN: {
+   monster creature(g->mtypes[c.mon]);
+   creature.spawn(c.x, c.y);
+   g->z.push_back(creature);
+  } break;
+
+  case FC_SCENT:
+   g->scent(c.x, c.y) = 0;
+   break;
+ }
+}
+
+field map::prev_field(int x, int y)
+{
+ if (!INBOUNDS(x, y))
+  return field();
+ if (!field_snapped[int(x / SEEX) + int(y / SEEY) * my_MAPSIZE])
+  return field();	// That submap had no fields at all
+ return field_prev[x * SEEY * MAPSIZE + y];
+}
+
 bool map::process_fields_in_submap(game *g, int gridn)
 {
  bool found_field = false;
- field *cur;
- field_id curtype;
+ submap &sm = grid[gridn];
+ std::vector<field_change> &changes = field_changes[gridn];
  for (int locx = 0; locx < SEEX; locx++) {
   for (int locy = 0; locy < SEEY; locy++) {
-   cur = &(grid[gridn].fld[locx][locy]);
+   field *cur = &(sm.fld[locx][locy]);
    int x = locx + SEEX * (gridn % my_MAPSIZE),
        y = locy + SEEY * int(gridn / my_MAPSIZE);
 
-   curtype = cur->type;
+   field_id curtype = cur->type;
    if (!found_field && curtype != fd_null)
     found_field = true;
-   if (cur->density > 3 || cur->density < 1)
-    debugmsg("Whoooooa density of %d", cur->density);
 
   if (cur->age == 0)	// Don't process "newborn" fields
    curtype = fd_null;
 
-  int part;
-  vehicle *veh;
+  bool wet = (terlist[sm.ter[locx][locy]].flags & mfb(swimmable));
   switch (curtype) {
 
    case fd_null:
@@ -48,408 +360,39 @@ bool map::process_fields_in_submap(game *g, int gridn)
 
    case fd_blood:
    case fd_bile:
-    if (has_flag(swimmable, x, y))	// Dissipate faster in water
+    if (wet)	// Dissipate faster in water
      cur->age += 250;
     break;
 
    case fd_acid:
-    if (has_flag(swimmable, x, y))	// Dissipate faster in water
+    if (wet)	// Dissipate faster in water
      cur->age += 20;
-    for (int i = 0; i < i_at(x, y).size(); i++) {
-     item *melting = &(i_at(x, y)[i]);
-     if (melting->made_of(LIQUID) || melting->made_of(VEGGY)   ||
-         melting->made_of(FLESH)  || melting->made_of(POWDER)  ||
-         melting->made_of(COTTON) || melting->made_of(WOOL)    ||
-         melting->made_of(PAPER)  || melting->made_of(PLASTIC) ||
-         (melting->made_of(GLASS) && !one_in(3)) || one_in(4)) {
-// Acid destructable objects here
-      melting->damage++;
-      if (melting->damage >= 5 ||
-          (melting->made_of(PAPER) && melting->damage >= 3)) {
-       cur->age += melting->volume();
-       for (int m = 0; m < i_at(x, y)[i].contents.size(); m++)
-        i_at(x, y).push_back( i_at(x, y)[i].contents[m] );
-       i_at(x, y).erase(i_at(x, y).begin() + i);
-       i--;
-      }
-     }
-    }
+    melt_items(cur, sm.itm[locx][locy]);
     break;
 
    case fd_sap:
     break; // It doesn't do anything.
 
-   case fd_fire: {
-// Consume items as fuel to help us grow/last longer.
-    bool destroyed = false;
-    int vol = 0, smoke = 0, consumed = 0;
-    for (int i = 0; i < i_at(x, y).size() && consumed < cur->density * 2; i++) {
-     destroyed = false;
-     vol = i_at(x, y)[i].volume();
-     item *it = &(i_at(x, y)[i]);
-
-     if (it->is_ammo() && it->ammo_type() != AT_BATT &&
-         it->ammo_type() != AT_NAIL && it->ammo_type() != AT_BB &&
-         it->ammo_type() != AT_BOLT && it->ammo_type() != AT_ARROW) {
-      cur->age /= 2;
-      cur->age -= 600;
-      destroyed = true;
-      smoke += 6;
-      consumed++;
-
-     } else if (it->made_of(PAPER)) {
-      destroyed = it->burn(cur->density * 3);
-      consumed++;
-      if (cur->density == 1)
-       cur->age -= vol * 10;
-      if (vol >= 4)
-       smoke++;
-
-     } else if ((it->made_of(WOOD) || it->made_of(VEGGY))) {
-      if (vol <= cur->density * 10 || cur->density == 3) {
-       cur->age -= 4;
-       destroyed = it->burn(cur->density);
-       smoke++;
-       consumed++;
-      } else if (it->burnt < cur->density) {
-       destroyed = it->burn(1);
-       smoke++;
-      }
-
-     } else if ((it->made_of(COTTON) || it->made_of(WOOL))) {
-      if (vol <= cur->density * 5 || cur->density == 3) {
-       cur->age--;
-       destroyed = it->burn(cur->density);
-       smoke++;
-       consumed++;
-      } else if (it->burnt < cur->density) {
-       destroyed = it->burn(1);
-       smoke++;
-      }
-
-     } else if (it->made_of(FLESH)) {
-      if (vol <= cur->density * 5 || (cur->density == 3 && one_in(vol / 20))) {
-       cur->age--;
-       destroyed = it->burn(cur->density);
-       smoke += 3;
-       consumed++;
-      } else if (it->burnt < cur->density * 5 || cur->density >= 2) {
-       destroyed = it->burn(1);
-       smoke++;
-      }
-
-     } else if (it->made_of(LIQUID)) {
-      switch (it->type->id) { // TODO: Make this be not a hack.
-       case itm_whiskey:
-       case itm_vodka:
-       case itm_rum:
-       case itm_tequila:
-        cur->age -= 300;
-        smoke += 6;
-        break;
-       default:
-        cur->age += rng(80 * vol, 300 * vol);
-        smoke++;
-      }
-      destroyed = true;
-      consumed++;
-
-     } else if (it->made_of(POWDER)) {
-      cur->age -= vol;
-      destroyed = true;
-      smoke += 2;
-
-     } else if (it->made_of(PLASTIC)) {
-      smoke += 3;
-      if (it->burnt <= cur->density * 2 || (cur->density == 3 && one_in(vol))) {
-       destroyed = it->burn(cur->density);
-       if (one_in(vol + it->burnt))
-        cur->age--;
-      }
-     }
-
-     if (destroyed) {
-      for (int m = 0; m < i_at(x, y)[i].contents.size(); m++)
-       i_at(x, y).push_back( i_at(x, y)[i].contents[m] );
-      i_at(x, y).erase(i_at(x, y).begin() + i);
-      i--;
-     }
-    }
-
-    veh = &(veh_at(x, y, part));
-    if (veh->type != veh_null && (veh->parts[part].flags & VHP_FUEL_TANK) && veh->fuel_type == AT_GAS)
-    {
-        if (cur->density > 1 && one_in (8) && veh->fuel > 0)
-            veh->explode (g, x, y);
-    }
-// Consume the terrain we're on
-    if (has_flag(explodes, x, y)) {
-     ter(x, y) = ter_id(int(ter(x, y)) + 1);
-     cur->age = 0;
-     cur->density = 3;
-     g->explosion(x, y, 40, 0, true);
-
-    } else if (has_flag(inflammable, x, y) && one_in(32 - cur->density * 10)) {
-     cur->age -= cur->density * cur->density * 40;
-     smoke += 15;
-     if (cur->density == 3)
-      ter(x, y) = t_ash;
-    } else if (has_flag(flammable,  x, y) && one_in(32 - cur->density * 10)) {
-     cur->age -= cur->density * cur->density * 40;
-     smoke += 15;
-     if (cur->density == 3)
-      ter(x, y) = t_rubble;
-    } else if (has_flag(meltable,  x, y) && one_in(32 - cur->density * 10)) {
-     cur->age -= cur->density * cur->density * 40;
-     if (cur->density == 3)
-      ter(x, y) = t_b_metal;
-    } else if (terlist[ter(x, y)].flags & mfb(swimmable))
-     cur->age += 800;	// Flames die quickly on water
-
-// If we consumed a lot, the flames grow higher
-    while (cur->density < 3 && cur->age < 0) {
-     cur->age += 300;
-     cur->density++;
-    }
-// If the flames are in a pit, it can't spread to non-pit
-    bool in_pit = (ter(x, y) == t_pit);
-// If the flames are REALLY big, they contribute to adjacent flames
-    if (cur->density == 3 && cur->age < 0) {
-// Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
-     int starti = rng(0, 2);
-     int startj = rng(0, 2);
-     for (int i = 0; i < 3 && cur->age < 0; i++) {
-      for (int j = 0; j < 3 && cur->age < 0; j++) {
-       int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
-       if (field_at(fx, fy).type == fd_fire && field_at(fx, fy).density < 3 &&
-           (!in_pit || ter(fx, fy) == t_pit)) {
-        field_at(fx, fy).density++;
-        field_at(fx, fy).age = 0;
-        cur->age = 0;
-       }
-      }
-     }
-    }
-// Consume adjacent fuel / terrain to spread.
-// Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
-    int starti = rng(0, 2);
-    int startj = rng(0, 2);
-    for (int i = 0; i < 3; i++) {
-     for (int j = 0; j < 3; j++) {
-      int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
-      if (INBOUNDS(fx, fy)) {
-       int spread_chance = 20 * (cur->density - 1) + 10 * smoke;
-       if (has_flag(explodes, fx, fy) && one_in(8 - cur->density)) {
-        ter(fx, fy) = ter_id(int(ter(fx, fy)) + 1);
-        g->explosion(fx, fy, 40, 0, true);
-       } else if ((i != 0 || j != 0) && rng(1, 100) < spread_chance &&
-                  (!in_pit || ter(fx, fy) == t_pit) &&
-                  ((cur->density == 3 &&
-                    (has_flag(flammable, fx, fy) || one_in(20))) ||
-                   flammable_items_at(fx, fy) ||
-                   field_at(fx, fy).type == fd_web)) {
-        if (field_at(fx, fy).type == fd_smoke ||
-            field_at(fx, fy).type == fd_web)
-         field_at(fx, fy) = field(fd_fire, 1, 0);
-        else
-         add_field(g, fx, fy, fd_fire, 1);
-       } else {
-        bool nosmoke = true;
-        for (int ii = -1; ii <= 1; ii++) {
-         for (int jj = -1; jj <= 1; jj++) {
-          if (field_at(x+ii, y+jj).type == fd_fire &&
-              field_at(x+ii, y+jj).density == 3)
-           smoke++;
-          else if (field_at(x+ii, y+jj).type == fd_smoke)
-           nosmoke = false;
-         }
-        }
-// If we're not spreading, maybe we'll stick out some smoke, huh?
-        if (move_cost(fx, fy) > 0 &&
-            (!one_in(smoke) || (nosmoke && one_in(40))) &&
-            rng(3, 35) < cur->density * 10 && cur->age < 1000) {
-         smoke--;
-         add_field(g, fx, fy, fd_smoke, rng(1, cur->density));
-        }
-       }
-      }
-     }
-    }
-   } break;
+   case fd_fire:
+    process_fire(g, x, y, cur, sm.itm[locx][locy], changes);
+    break;
 
    case fd_smoke:
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
-    if (is_outside(x, y))
-     cur->age += 50;
-    if (one_in(2)) {
-     std::vector <point> spread;
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if ((field_at(x+a, y+b).type == fd_smoke &&
-             field_at(x+a, y+b).density < 3       ) ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-      if (field_at(p.x, p.y).type == fd_smoke &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_smoke, 1)){
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
-   break;
-
    case fd_tear_gas:
-// Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
-    if (is_outside(x, y))
-     cur->age += 30;
-// One in three chance that it spreads (less than smoke!)
-    if (one_in(3)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby teargas grows thicker
-      if (field_at(p.x, p.y).type == fd_tear_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke is converted into teargas
-      } else if (field_at(p.x, p.y).type == fd_smoke) {
-       field_at(p.x, p.y).type = fd_tear_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_tear_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
-    break;
-
    case fd_toxic_gas:
-// Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
-    if (is_outside(x, y))
-     cur->age += 40;
-    if (one_in(2)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas ||
-             field_at(x+a, y+b).type == fd_toxic_gas ||
-             field_at(x+a, y+b).type == fd_nuke_gas   ) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby toxic gas grows thicker
-      if (field_at(p.x, p.y).type == fd_toxic_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke & teargas is converted into toxic gas
-      } else if (field_at(p.x, p.y).type == fd_smoke ||
-                 field_at(p.x, p.y).type == fd_tear_gas) {
-       field_at(p.x, p.y).type = fd_toxic_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_toxic_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
-    break;
-
-
    case fd_nuke_gas:
-// Reset nearby scents to zero
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++)
-      g->scent(x+i, y+j) = 0;
-    }
-    if (is_outside(x, y))
-     cur->age += 40;
-// Increase long-term radiation in the land underneath
-    radiation(x, y) += rng(0, cur->density);
-    if (one_in(2)) {
-     std::vector <point> spread;
-// Pick all eligible points to spread to
-     for (int a = -1; a <= 1; a++) {
-      for (int b = -1; b <= 1; b++) {
-       if (((field_at(x+a, y+b).type == fd_smoke ||
-             field_at(x+a, y+b).type == fd_tear_gas ||
-             field_at(x+a, y+b).type == fd_toxic_gas ||
-             field_at(x+a, y+b).type == fd_nuke_gas   ) &&
-             field_at(x+a, y+b).density < 3            )      ||
-           (field_at(x+a, y+b).is_null() && move_cost(x+a, y+b) > 0))
-        spread.push_back(point(x+a, y+b));
-      }
-     }
-// Then, spread to a nearby point
-     if (cur->density > 0 && cur->age > 0 && spread.size() > 0) {
-      point p = spread[rng(0, spread.size() - 1)];
-// Nearby nukegas grows thicker
-      if (field_at(p.x, p.y).type == fd_nuke_gas &&
-          field_at(p.x, p.y).density < 3) {
-        field_at(p.x, p.y).density++;
-        cur->density--;
-// Nearby smoke, tear, and toxic gas is converted into nukegas
-      } else if (field_at(p.x, p.y).type == fd_smoke ||
-                 field_at(p.x, p.y).type == fd_toxic_gas ||
-                 field_at(p.x, p.y).type == fd_tear_gas) {
-       field_at(p.x, p.y).type = fd_nuke_gas;
-// Or, just create a new field.
-      } else if (cur->density > 0 && move_cost(p.x, p.y) > 0 &&
-                 add_field(g, p.x, p.y, fd_nuke_gas, 1)) {
-       cur->density--;
-       field_at(p.x, p.y).age = cur->age;
-      }
-     }
-    }
+    spread_gas(g, x, y, cur, changes);
     break;
 
    case fd_gas_vent:
     for (int i = x - 1; i <= x + 1; i++) {
      for (int j = y - 1; j <= y + 1; j++) {
-      if (field_at(i, j).type == fd_toxic_gas && field_at(i, j).density < 3)
-       field_at(i, j).density++;
+      field there = prev_field(i, j);
+      if (there.type == fd_toxic_gas && there.density < 3)
+       changes.push_back(field_change(FC_THICKEN, i, j, fd_toxic_gas,
+                                      1, -1));
       else
-       add_field(g, i, j, fd_toxic_gas, 3);
+       changes.push_back(field_change(FC_ADD, i, j, fd_toxic_gas, 3));
      }
     }
     break;
@@ -473,15 +416,22 @@ bool map::process_fields_in_submap(game *g, int gridn)
     }
     break;
 
+// Electricity keeps spreading until it runs out of empty squares, so it
+// remembers the ones it has already charged this pass
    case fd_electricity:
     if (!one_in(5)) {	// 4 in 5 chance to spread
      std::vector<point> valid;
      if (move_cost(x, y) == 0 && cur->density > 1) { // We're grounded
+      std::vector<point> charged;
       int tries = 0;
       while (tries < 10 && cur->age < 50) {
        int cx = x + rng(-1, 1), cy = y + rng(-1, 1);
-       if (move_cost(cx, cy) != 0 && field_at(cx, cy).is_null()) {
-        add_field(g, cx, cy, fd_electricity, 1);
+       bool done = false;
+       for (int i = 0; i < charged.size() && !done; i++)
+        done = (charged[i].x == cx && charged[i].y == cy);
+       if (move_cost(cx, cy) != 0 && prev_field(cx, cy).is_null() && !done) {
+        changes.push_back(field_change(FC_ADD, cx, cy, fd_electricity));
+        charged.push_back(point(cx, cy));
         cur->density--;
         tries = 0;
        } else
@@ -491,22 +441,25 @@ bool map::process_fields_in_submap(game *g, int gridn)
       for (int a = -1; a <= 1; a++) {
        for (int b = -1; b <= 1; b++) {
         if (move_cost(x + a, y + b) == 0 && // Grounded tiles first
-            field_at(x + a, y + b).is_null())
+            prev_field(x + a, y + b).is_null())
          valid.push_back(point(x + a, y + b));
        }
       }
       if (valid.size() == 0) {	// Spread to adjacent space, then
        int px = x + rng(-1, 1), py = y + rng(-1, 1);
-       if (move_cost(px, py) > 0 && field_at(px, py).type == fd_electricity &&
-           field_at(px, py).density < 3)
-        field_at(px, py).density++;
+       field there = prev_field(px, py);
+       if (move_cost(px, py) > 0 && there.type == fd_electricity &&
+           there.density < 3)
+        changes.push_back(field_change(FC_THICKEN, px, py,
+                                       fd_electricity, 1, -1));
        else if (move_cost(px, py) > 0)
-        add_field(g, px, py, fd_electricity, 1);
+        changes.push_back(field_change(FC_ADD, px, py, fd_electricity));
        cur->density--;
       }
       while (valid.size() > 0 && cur->density > 0) {
        int index = rng(0, valid.size() - 1);
-       add_field(g, valid[index].x, valid[index].y, fd_electricity, 1);
+       changes.push_back(field_change(FC_ADD, valid[index].x,
+                                      valid[index].y, fd_electricity));
        cur->density--;
        valid.erase(valid.begin() + index);
       }
@@ -519,9 +472,9 @@ bool map::process_fields_in_submap(game *g, int gridn)
      cur->density++;
     else if (cur->density == 3 && one_in(600)) { // Spawn nether creature!
      mon_id type = mon_id(rng(mon_flying_polyp, mon_blank));
-     monster creature(g->mtypes[type]);
-     creature.spawn(x + rng(-3, 3), y + rng(-3, 3));
-     g->z.push_back(creature);
+     field_change spawn(FC_SPAWN, x + rng(-3, 3), y + rng(-3, 3));
+     spawn.mon = type;
+     changes.push_back(spawn);
     }
     break;
    }
@@ -534,8 +487,8 @@ bool map::process_fields_in_submap(game *g, int gridn)
      cur->density--;
     }
     if (cur->density <= 0) { // Totally dissapated.
-     grid[gridn].field_count--;
-     grid[gridn].fld[locx][locy] = field();
+     sm.field_count--;
+     sm.fld[locx][locy] = field();
     }
    }
   }
@@ -543,6 +496,281 @@ bool map::process_fields_in_submap(game *g, int gridn)
  return found_field;
 }
 
+// Acid eats away at the items lying in it
+void map::melt_items(field *cur, std::vector<item> &items)
+{
+ for (int i = 0; i < items.size(); i++) {
+  item *melting = &(items[i]);
+  if (melting->made_of(LIQUID) || melting->made_of(VEGGY)   ||
+      melting->made_of(FLESH)  || melting->made_of(POWDER)  ||
+      melting->made_of(COTTON) || melting->made_of(WOOL)    ||
+      melting->made_of(PAPER)  || melting->made_of(PLASTIC) ||
+      (melting->made_of(GLASS) && !one_in(3)) || one_in(4)) {
+// Acid destructable objects here
+   melting->damage++;
+   if (melting->damage >= 5 ||
+       (melting->made_of(PAPER) && melting->damage >= 3)) {
+    cur->age += melting->volume();
+    for (int m = 0; m < items[i].contents.size(); m++)
+     items.push_back( items[i].contents[m] );
+    items.erase(items.begin() + i);
+    i--;
+   }
+  }
+ }
+}
+
+void map::process_fire(game *g, int x, int y, field *cur,
+                       std::vector<item> &items,
+                       std::vector<field_change> &changes)
+{
+// Consume items as fuel to help us grow/last longer.
+ bool destroyed = false;
+ int vol = 0, smoke = 0, consumed = 0, part;
+ for (int i = 0; i < items.size() && consumed < cur->density * 2; i++) {
+  destroyed = false;
+  vol = items[i].volume();
+  item *it = &(items[i]);
+
+  if (it->is_ammo() && it->ammo_type() != AT_BATT &&
+      it->ammo_type() != AT_NAIL && it->ammo_type() != AT_BB &&
+      it->ammo_type() != AT_BOLT && it->ammo_type() != AT_ARROW) {
+   cur->age /= 2;
+   cur->age -= 600;
+   destroyed = true;
+   smoke += 6;
+   consumed++;
+
+  } else if (it->made_of(PAPER)) {
+   destroyed = it->burn(cur->density * 3);
+   consumed++;
+   if (cur->density == 1)
+    cur->age -= vol * 10;
+   if (vol >= 4)
+    smoke++;
+
+  } else if ((it->made_of(WOOD) || it->made_of(VEGGY))) {
+   if (vol <= cur->density * 10 || cur->density == 3) {
+    cur->age -= 4;
+    destroyed = it->burn(cur->density);
+    smoke++;
+    consumed++;
+   } else if (it->burnt < cur->density) {
+    destroyed = it->burn(1);
+    smoke++;
+   }
+  } else if ((it->made_of(COTTON) || it->made_of(WOOL))) {
+   if (vol <= cur->density * 5 || cur->density == 3) {
+    cur->age--;
+    destroyed = it->burn(cur->density);
+    smoke++;
+    consumed++;
+   } else if (it->burnt < cur->density) {
+    destroyed = it->burn(1);
+    smoke++;
+   }
+
+  } else if (it->made_of(FLESH)) {
+   if (vol <= cur->density * 5 || (cur->density == 3 && one_in(vol / 20))) {
+    cur->age--;
+    destroyed = it->burn(cur->density);
+    smoke += 3;
+    consumed++;
+   } else if (it->burnt < cur->density * 5 || cur->density >= 2) {
+    destroyed = it->burn(1);
+    smoke++;
+   }
+
+  } else if (it->made_of(LIQUID)) {
+   switch (it->type->id) { // TODO: Make this be not a hack.
+    case itm_whiskey:
+    case itm_vodka:
+    case itm_rum:
+    case itm_tequila:
+     cur->age -= 300;
+     smoke += 6;
+     break;
+    default:
+     cur->age += rng(80 * vol, 300 * vol);
+     smoke++;
+   }
+   destroyed = true;
+   consumed++;
+
+  } else if (it->made_of(POWDER)) {
+   cur->age -= vol;
+   destroyed = true;
+   smoke += 2;
+
+  } else if (it->made_of(PLASTIC)) {
+   smoke += 3;
+   if (it->burnt <= cur->density * 2 || (cur->density == 3 && one_in(vol))) {
+    destroyed = it->burn(cur->density);
+    if (one_in(vol + it->burnt))
+     cur->age--;
+   }
+  }
+
+  if (destroyed) {
+   for (int m = 0; m < items[i].contents.size(); m++)
+    items.push_back( items[i].contents[m] );
+   items.erase(items.begin() + i);
+   i--;
+  }
+ }
+
+ vehicle *veh = &(veh_at(x, y, part));
+ if (veh->type != veh_null && (veh->parts[part].flags & VHP_FUEL_TANK) && veh->fuel_type == AT_GAS)
+ {
+     if (cur->density > 1 && one_in (8) && veh->fuel > 0)
+         changes.push_back(field_change(FC_VEH_EXPLODE, x, y));
+ }
+// Consume the terrain we're on
+ ter_id terrain = ter(x, y);
+ unsigned long flags = terlist[terrain].flags;
+ if (flags & mfb(explodes)) {
+  changes.push_back(field_change(FC_DETONATE, x, y));
+  cur->age = 0;
+  cur->density = 3;
+
+ } else if ((flags & mfb(inflammable)) && one_in(32 - cur->density * 10)) {
+  cur->age -= cur->density * cur->density * 40;
+  smoke += 15;
+  if (cur->density == 3)
+   changes.push_back(field_change(FC_TERRAIN, x, y, fd_null, 0, 0,
+                                  t_ash));
+ } else if ((flags & mfb(flammable)) && one_in(32 - cur->density * 10)) {
+  cur->age -= cur->density * cur->density * 40;
+  smoke += 15;
+  if (cur->density == 3)
+   changes.push_back(field_change(FC_TERRAIN, x, y, fd_null, 0, 0,
+                                  t_rubble));
+ } else if ((flags & mfb(meltable)) && one_in(32 - cur->density * 10)) {
+  cur->age -= cur->density * cur->density * 40;
+  if (cur->density == 3)
+   changes.push_back(field_change(FC_TERRAIN, x, y, fd_null, 0, 0,
+                                  t_b_metal));
+ } else if (flags & mfb(swimmable))
+  cur->age += 800;	// Flames die quickly on water
+
+// If we consumed a lot, the flames grow higher
+ while (cur->density < 3 && cur->age < 0) {
+  cur->age += 300;
+  cur->density++;
+ }
+// If the flames are in a pit, it can't spread to non-pit
+ bool in_pit = (terrain == t_pit);
+// If the flames are REALLY big, they contribute to adjacent flames
+ if (cur->density == 3 && cur->age < 0) {
+// Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
+  int starti = rng(0, 2);
+  int startj = rng(0, 2);
+  for (int i = 0; i < 3 && cur->age < 0; i++) {
+   for (int j = 0; j < 3 && cur->age < 0; j++) {
+    int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
+    field there = prev_field(fx, fy);
+    if (there.type == fd_fire && there.density < 3 &&
+        (!in_pit || ter(fx, fy) == t_pit)) {
+     changes.push_back(field_change(FC_THICKEN, fx, fy, fd_fire, 1, 0));
+     cur->age = 0;
+    }
+   }
+  }
+ }
+// Consume adjacent fuel / terrain to spread.
+// Randomly offset our x/y shifts by 0-2, to randomly pick a square to spread to
+ int starti = rng(0, 2);
+ int startj = rng(0, 2);
+ for (int i = 0; i < 3; i++) {
+  for (int j = 0; j < 3; j++) {
+   int fx = x + ((i + starti) % 3) - 1, fy = y + ((j + startj) % 3) - 1;
+   if (INBOUNDS(fx, fy)) {
+    int spread_chance = 20 * (cur->density - 1) + 10 * smoke;
+    if (has_flag(explodes, fx, fy) && one_in(8 - cur->density)) {
+     changes.push_back(field_change(FC_DETONATE, fx, fy));
+    } else if ((i != 0 || j != 0) && rng(1, 100) < spread_chance &&
+               (!in_pit || ter(fx, fy) == t_pit) &&
+               ((cur->density == 3 &&
+                 (has_flag(flammable, fx, fy) || one_in(20))) ||
+                field_fuel.count(fx * SEEY * MAPSIZE + fy) > 0 ||
+                prev_field(fx, fy).type == fd_web)) {
+     changes.push_back(field_change(FC_IGNITE, fx, fy, fd_fire));
+    } else {
+     bool nosmoke = true;
+     for (int ii = -1; ii <= 1; ii++) {
+      for (int jj = -1; jj <= 1; jj++) {
+       field near = prev_field(x + ii, y + jj);
+       if (near.type == fd_fire && near.density == 3)
+        smoke++;
+       else if (near.type == fd_smoke)
+        nosmoke = false;
+      }
+     }
+// If we're not spreading, maybe we'll stick out some smoke, huh?
+     if (move_cost(fx, fy) > 0 &&
+         (!one_in(smoke) || (nosmoke && one_in(40))) &&
+         rng(3, 35) < cur->density * 10 && cur->age < 1000) {
+      smoke--;
+      changes.push_back(field_change(FC_ADD, fx, fy, fd_smoke,
+                                     rng(1, cur->density)));
+     }
+    }
+   }
+  }
+ }
+}
+
+// Gases drift to a random neighbour, thickening their own kind and turning
+// weaker gases into themselves.  Toxic gas has always counted thin nuke gas
+// as somewhere to drift to, though it can do nothing there; the roll is lost.
+void map::spread_gas(game *g, int x, int y, field *cur,
+                     std::vector<field_change> &changes)
+{
+ field_id type = cur->type;
+ int rank = gas_rank(type);
+ int reach = (type == fd_toxic_gas ? gas_rank(fd_nuke_gas) : rank);
+// Reset nearby scents to zero
+ for (int i = -1; i <= 1; i++) {
+  for (int j = -1; j <= 1; j++)
+   changes.push_back(field_change(FC_SCENT, x + i, y + j));
+ }
+ if (is_outside(x, y))
+  cur->age += (type == fd_smoke ? 50 : (type == fd_tear_gas ? 30 : 40));
+// Increase long-term radiation in the land underneath
+ if (type == fd_nuke_gas)
+  radiation(x, y) += rng(0, cur->density);
+ if (!one_in(type == fd_tear_gas ? 3 : 2))	// Tear gas spreads less
+  return;
+ std::vector <point> spread;
+// Pick all eligible points to spread to
+ for (int a = -1; a <= 1; a++) {
+  for (int b = -1; b <= 1; b++) {
+   field there = prev_field(x + a, y + b);
+   int there_rank = gas_rank(there.type);
+   if ((there_rank > 0 && there_rank <= reach && there.density < 3) ||
+       (there.is_null() && move_cost(x + a, y + b) > 0))
+    spread.push_back(point(x + a, y + b));
+  }
+ }
+ if (cur->density <= 0 || cur->age <= 0 || spread.size() == 0)
+  return;
+// Then, spread to a nearby point
+ point p = spread[rng(0, spread.size() - 1)];
+ field target = prev_field(p.x, p.y);
+ int target_rank = gas_rank(target.type);
+ if (target_rank > 0 && target_rank < rank) {
+  changes.push_back(field_change(FC_CONVERT, p.x, p.y, type));
+ } else if ((target.type == type && target.density < 3) ||
+            (target.is_null() && move_cost(p.x, p.y) > 0)) {
+// The target may fill up before this lands; if so, it comes back to us
+  field_change drift(FC_GAS, p.x, p.y, type, 1, cur->age);
+  drift.srcx = x;
+  drift.srcy = y;
+  changes.push_back(drift);
+  cur->density--;
+ }
+}
+
 void map::step_in_field(int x, int y, game *g)
 {
  field *cur = &field_at(x, y);
@@ -11,6 +11,8 @@
 #include <math.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <queue>
+#include <algorithm>
 #include <sys/stat.h>
 
 #define MAX_MONSTERS_MOVING 40 // Efficiency!
@@ -69,9 +71,12 @@ game::game()
  weather = WEATHER_CLEAR; // Start with some nice weather...
  nextweather = MINUTES(STARTING_MINUTES + 30); // Weather shift in 30
  turnssincelastmon = 0; //Auto safe mode init
+ pursuit_turn = -1;	// No pursuit map built yet
+ spawn_check_turn = -1;
+ ff_skipped = 0;
  autosafemode = true;
 
- turn.season = SUMMER;    // ... with winter conveniently a long ways off
+ turn = DAYS(DAYS_IN_SEASON * int(SUMMER)); // Winter's a long ways off
 
  for (int i = 0; i < num_monsters; i++)	// Reset kill counts to 0
   kills[i] = 0;
@@ -378,6 +383,7 @@ fivedozenwhales@gmail.com.");
 void game::start_game()
 {
  turn = MINUTES(STARTING_MINUTES);// It's turn 0...
+ events.reset(int(turn));
  run_mode = 1;	// run_mode is on by default...
  mostseen = 0;	// ...and mostseen is 0, we haven't seen any monsters yet.
 
@@ -414,6 +420,7 @@ void game::start_game()
  u.int_cur = u.int_max;
  u.dex_cur = u.dex_max;
  nextspawn = int(turn);
+ schedule_tasks();
  temperature = 65; // Springtime-appropriate?
 
 // Put some NPCs in there!
@@ -481,6 +488,7 @@ void game::start_tutorial(tut_type type)
   levz = 0;
   u.posx = SEEX + 2;
   u.posy = SEEY + 4;
+  schedule_tasks();
   break;
  default:
   debugmsg("Haven't made that tutorial yet.");
@@ -544,7 +552,7 @@ bool game::do_turn()
     if (group != -1) {
      cur_om.zg[group].population++;
      if (cur_om.zg[group].population / pow(cur_om.zg[group].radius, 2.0) > 5)
-      cur_om.zg[group].radius++;
+      cur_om.grow_mongroup(group);
     }
    }
   }
@@ -557,7 +565,7 @@ bool game::do_turn()
  turn.increment();
  process_events();
  process_missions();
- if (turn.hour == 0 && turn.minute == 0 && turn.second == 0) // Midnight!
+ if (turn.hour() == 0 && turn.minute() == 0 && turn.second() == 0) // Midnight!
   cur_om.process_mongroups();
 
  if (in_tutorial) {
@@ -580,7 +588,21 @@ bool game::do_turn()
   u.hp_cur[hp_torso] = 0;
  }
 
- if (turn % 50 == 0) {	// Hunger, thirst, & fatigue up every 5 minutes
+ std::vector<event> due;
+ bool upkeep = false, half_hour = false, weather_due = false, spawn_due = false;
+ tasks.advance(int(turn), due);
+ for (int i = 0; i < due.size(); i++) {
+  switch (due[i].type) {
+   case TASK_UPKEEP:	upkeep = true;		break;
+   case TASK_HALF_HOUR:	half_hour = true;	break;
+   case TASK_WEATHER:	weather_due = true;	break;
+   case TASK_SPAWN:	// Earlier ones went stale when nextspawn moved
+    spawn_due |= (due[i].turn == spawn_check_turn);
+    break;
+   default:		break;
+  }
+ }
+ if (upkeep) {	// Hunger, thirst, & fatigue up every 5 minutes
   if ((!u.has_trait(PF_LIGHTEATER) || !one_in(3)) &&
       (!u.has_bionic(bio_recycler) || turn % 300 == 0))
    u.hunger++;
@@ -602,8 +624,10 @@ bool game::do_turn()
    u.pkill++;
   if (u.has_bionic(bio_solar) && is_in_sunlight(u.posx, u.posy))
    u.charge_power(1);
+  tasks.add(event(TASK_UPKEEP, int(turn) + 50 - int(turn) % 50, -1, -1, -1));
+  schedule_spawn_check();	// A mutation may have brought it forward
  }
- if (turn % 300 == 0) {	// Pain up/down every 30 minutes
+ if (half_hour) {	// Pain up/down every 30 minutes
   if (u.pain > 0)
    u.pain--;
   else if (u.pain < 0)
@@ -621,18 +645,26 @@ bool game::do_turn()
   if (u.radiation > 1 && one_in(3))
    u.radiation--;
   u.get_sick(this);
+  tasks.add(event(TASK_HALF_HOUR, int(turn) + 300 - int(turn) % 300,
+                  -1, -1, -1));
 // Auto-save on the half-hour
   save();
  }
 // Update the weather, if it's time.
- if (turn >= nextweather)
+ if (weather_due) {
   update_weather();
+  tasks.add(event(TASK_WEATHER, int(nextweather), -1, -1, -1));
+ }
 
 // The following happens when we stay still; 10/40 minutes overdue for spawn
- if ((!u.has_trait(PF_INCONSPICUOUS) && turn > nextspawn +  100) ||
-     ( u.has_trait(PF_INCONSPICUOUS) && turn > nextspawn +  400)   ) {
-  spawn_mon(-1 + 2 * rng(0, 1), -1 + 2 * rng(0, 1));
-  nextspawn = turn;
+ if (spawn_due) {
+  spawn_check_turn = -1;
+  if ((!u.has_trait(PF_INCONSPICUOUS) && turn > nextspawn +  100) ||
+      ( u.has_trait(PF_INCONSPICUOUS) && turn > nextspawn +  400)   ) {
+   spawn_mon(-1 + 2 * rng(0, 1), -1 + 2 * rng(0, 1));
+   nextspawn = turn;
+  }
+  schedule_spawn_check();
  }
  process_activity();
 
@@ -649,13 +681,26 @@ bool game::do_turn()
    return true;
   }
  }
- update_scent();
+// Nothing's near enough to matter, so let the world wait a few turns
+ bool skip_world = (ff_skipped < FF_STRIDE - 1 && fast_forward());
+ if (skip_world)
+  ff_skipped++;
+ else {
+  if (ff_skipped > 0)
+   m.age_fields(this, ff_skipped);
+  ff_skipped = 0;
+  update_scent();
+ }
  m.vehmove(this);
- m.process_fields(this);
+ if (!skip_world)
+  m.process_fields(this);
  m.process_active_items(this);
  m.step_in_field(u.posx, u.posy, this);
 
- monmove();
+ if (!skip_world) {
+  process_sounds();
+  monmove();
+ }
  update_stair_monsters();
  om_npcs_move();
  u.reset(this);
@@ -716,14 +761,40 @@ void game::update_skills()
 
 void game::process_events()
 {
- for (int i = 0; i < events.size(); i++) {
-  events[i].per_turn(this);
-  if (events[i].turn <= int(turn)) {
-   events[i].actualize(this);
-   events.erase(events.begin() + i);
-   i--;
-  }
- }
+ for (int i = 0; i < events.ticking.size(); i++)
+  events.ticking[i].per_turn(this);
+ std::vector<event> due;
+ events.advance(int(turn), due);
+ for (int i = 0; i < due.size(); i++)
+  due[i].actualize(this);
+}
+
+// The periodic work in do_turn() is filed in tasks, so turns with nothing due
+//  don't look at it.  Upkeep goes off on every 50th and 300th turn, weather on
+//  nextweather, and the spawn check once we've been still 10 minutes (40 if
+//  inconspicuous) past nextspawn.  It's all worked out again from those on
+//  load, so none of it is saved.
+void game::schedule_tasks()
+{
+ tasks.reset(int(turn));
+ tasks.add(event(TASK_UPKEEP, int(turn) + 50 - int(turn) % 50, -1, -1, -1));
+ tasks.add(event(TASK_HALF_HOUR, int(turn) + 300 - int(turn) % 300,
+                 -1, -1, -1));
+ tasks.add(event(TASK_WEATHER, int(nextweather), -1, -1, -1));
+ spawn_check_turn = -1;
+ schedule_spawn_check();
+}
+
+// There's only ever one live spawn check.  If nextspawn moves later, it goes
+//  off early, finds nothing to do, and files itself again; if it moves sooner,
+//  we file a new one and the old one goes stale.
+void game::schedule_spawn_check()
+{
+ int due = int(nextspawn) + (u.has_trait(PF_INCONSPICUOUS) ? 400 : 100) + 1;
+ if (spawn_check_turn != -1 && spawn_check_turn <= due)
+  return;
+ spawn_check_turn = due;
+ tasks.add(event(TASK_SPAWN, due, -1, -1, -1));
 }
 
 void game::process_activity()
@@ -852,7 +923,7 @@ void game::cancel_activity_query(std::string message)
 
 void game::update_weather()
 {
- season_type season = turn.season;
+ season_type season = turn.season();
 // Pick a new weather type (most likely the same one)
  int chances[NUM_WEATHER_TYPES];
  int total = 0;
@@ -1296,39 +1367,53 @@ int& game::scent(int x, int y)
 
 void game::update_scent()
 {
- signed int newscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
  if (!u.has_active_bionic(bio_scent_mask))
   grscent[u.posx][u.posy] = u.scent;
  else
   grscent[u.posx][u.posy] = 0;
 
- for (int x = u.posx - 18; x <= u.posx + 18; x++) {
-  for (int y = u.posy - 18; y <= u.posy + 18; y++) {
-   newscent[x][y] = 0;
-   if (m.move_cost(x, y) != 0 || m.has_flag(bashable, x, y)) {
-    int squares_used = 0;
-    for (int i = -1; i <= 1; i++) {
-     for (int j = -1; j <= 1; j++) {
-      if (grscent[x][y] <= grscent[x+i][y+j]) {
-       newscent[x][y] += grscent[x+i][y+j];
-       squares_used++;
-      }
-     }
-    }
-    newscent[x][y] /= (squares_used + 1);
-    if (m.field_at(x, y).type == fd_slime &&
-        newscent[x][y] < 10 * m.field_at(x, y).density)
-     newscent[x][y] = 10 * m.field_at(x, y).density;
-    if (newscent[x][y] > 10000) {
-     debugmsg("Wacky scent at %d, %d (%d)", x, y, newscent[x][y]);
-     newscent[x][y] = 0; // Scent should never be higher
+// Stay a square in from the edge of the bubble, so every neighbour exists
+ int minx = u.posx - SCENT_RADIUS, maxx = u.posx + SCENT_RADIUS,
+     miny = u.posy - SCENT_RADIUS, maxy = u.posy + SCENT_RADIUS;
+ if (minx < 1) minx = 1;
+ if (miny < 1) miny = 1;
+ if (maxx > SEEX * MAPSIZE - 2) maxx = SEEX * MAPSIZE - 2;
+ if (maxy > SEEY * MAPSIZE - 2) maxy = SEEY * MAPSIZE - 2;
+// Look up the terrain and fields first, so the spreading below is just sums
+ for (int x = minx; x <= maxx; x++) {
+  for (int y = miny; y <= maxy; y++) {
+   if (m.move_cost(x, y) == 0 && !m.has_flag(bashable, x, y))
+    scent_floor[x][y] = -1;
+   else {
+    field &fd = m.field_at(x, y);
+    scent_floor[x][y] = (fd.type == fd_slime ? 10 * fd.density : 0);
+   }
+  }
+ }
+// Each square averages itself with the neighbours that smell at least as
+// strongly; counting with 0/1 rather than branching keeps the loop tight
+ for (int x = minx; x <= maxx; x++) {
+  for (int y = miny; y <= maxy; y++) {
+   int here = grscent[x][y], sum = 0, used = 1;
+   for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+     int there = grscent[x + i][y + j], stronger = (here <= there);
+     sum += there * stronger;
+     used += stronger;
     }
    }
+   int least = scent_floor[x][y], spread = sum / used;
+   scent_buf[x][y] = (least < 0 ? 0 : (spread < least ? least : spread));
   }
  }
- for (int x = u.posx - 18; x <= u.posx + 18; x++) {
-  for (int y = u.posy - 18; y <= u.posy + 18; y++)
-   grscent[x][y] = newscent[x][y];
+ for (int x = minx; x <= maxx; x++) {
+  for (int y = miny; y <= maxy; y++) {
+   if (scent_buf[x][y] > 10000) {
+    debugmsg("Wacky scent at %d, %d (%d)", x, y, scent_buf[x][y]);
+    scent_buf[x][y] = 0; // Scent should never be higher
+   }
+   grscent[x][y] = scent_buf[x][y];
+  }
  }
  if (!u.has_active_bionic(bio_scent_mask))
   grscent[u.posx][u.posy] = u.scent;
@@ -1336,6 +1421,206 @@ void game::update_scent()
   grscent[u.posx][u.posy] = 0;
 }
 
+struct pursuit_node {
+ int dist, x, y;
+ pursuit_node(int D, int X, int Y) : dist (D), x (X), y (Y) {}
+ bool operator< (const pursuit_node &b) const { return dist > b.dist; }
+};
+
+int game::pursuit_dist(int x, int y)
+{
+ if (PURSUIT_RANGE <= 0 ||
+     x < 0 || x >= SEEX * MAPSIZE || y < 0 || y >= SEEY * MAPSIZE)
+  return 999;
+ if (pursuit_turn != int(turn) || pursuit_x != u.posx || pursuit_y != u.posy ||
+     pursuit_gen != m.tile_gen)
+  update_pursuit();
+ return pursuit[x][y];
+}
+
+// Dijkstra outward from the player, so every monster chasing us this turn
+// shares one search instead of each walking its own line.  Doors and other
+// bashable terrain are passable at a premium, like in map::route().
+void game::update_pursuit()
+{
+ pursuit_turn = int(turn);
+ pursuit_x = u.posx;
+ pursuit_y = u.posy;
+ pursuit_gen = m.tile_gen;
+ for (int x = 0; x < SEEX * MAPSIZE; x++) {
+  for (int y = 0; y < SEEY * MAPSIZE; y++)
+   pursuit[x][y] = 999;
+ }
+ std::priority_queue<pursuit_node> open;
+ pursuit[u.posx][u.posy] = 0;
+ open.push(pursuit_node(0, u.posx, u.posy));
+ while (!open.empty()) {
+  pursuit_node cur = open.top();
+  open.pop();
+  if (cur.dist > pursuit[cur.x][cur.y])
+   continue;	// Stale entry; we already found a shorter way here
+  for (int i = -1; i <= 1; i++) {
+   for (int j = -1; j <= 1; j++) {
+    int x = cur.x + i, y = cur.y + j;
+    if ((i == 0 && j == 0) || x < 0 || x >= SEEX * MAPSIZE ||
+        y < 0 || y >= SEEY * MAPSIZE ||
+        rl_dist(u.posx, u.posy, x, y) > PURSUIT_RANGE)
+     continue;
+    int cost = m.move_cost(x, y);
+    if (cost == 0) {
+     if (!m.has_flag(bashable, x, y))
+      continue;
+     cost = (m.ter(x, y) == t_door_c ? 4 : 18);
+    }
+    if (cur.dist + cost < pursuit[x][y]) {
+     pursuit[x][y] = cur.dist + cost;
+     open.push(pursuit_node(pursuit[x][y], x, y));
+    }
+   }
+  }
+ }
+}
+
+// How hard an overmap tile is to cross on foot; 0 means it can't be crossed.
+static int oter_travel_cost(oter_id ter)
+{
+ if (ter == ot_null || ter == ot_rock || ter == ot_rift || ter == ot_hellmouth)
+  return 0;
+ if (ter >= ot_hiway_ns && ter <= ot_bridge_ew)
+  return 1;	// Highways, roads and bridges
+ if (ter >= ot_river_center && ter <= ot_river_nw)
+  return 20;	// Swimming
+ switch (ter) {
+  case ot_field:		return 2;
+  case ot_forest:		return 4;
+  case ot_forest_thick:		return 6;
+  case ot_forest_water:		return 8;
+  default:			return 3;	// Buildings, labs, tunnels...
+ }
+}
+
+// Only reads overmaps which are already in memory; tiles on any overmap we
+// don't have loaded are treated as impassable rather than loading it.
+int game::om_travel_cost(int x, int y)
+{
+ int ox = (x < 0 ? -1 : (x >= OMAPX ? 1 : 0)),
+     oy = (y < 0 ? -1 : (y >= OMAPY ? 1 : 0));
+ overmap *om = &cur_om;
+ if (ox != 0 && oy != 0)
+  om = om_diag;
+ else if (ox != 0)
+  om = om_hori;
+ else if (oy != 0)
+  om = om_vert;
+ if (om == NULL || abs(ox) > 1 || abs(oy) > 1 ||
+     om->posx != cur_om.posx + ox || om->posy != cur_om.posy + oy ||
+     om->posz != cur_om.posz)
+  return 0;
+ return oter_travel_cost(om->ter(x - ox * OMAPX, y - oy * OMAPY));
+}
+
+std::vector<int> game::om_route_stamp()
+{
+ std::vector<int> ret;
+ ret.push_back(cur_om.posx);
+ ret.push_back(cur_om.posy);
+ ret.push_back(cur_om.posz);
+ overmap *adj[3] = {om_hori, om_vert, om_diag};
+ for (int i = 0; i < 3; i++) {
+  ret.push_back(adj[i] == NULL ? -999 : adj[i]->posx);
+  ret.push_back(adj[i] == NULL ? -999 : adj[i]->posy);
+ }
+ ret.push_back(int(turn) / HOURS(1)); // Pick up overmap terrain changes hourly
+ return ret;
+}
+
+// A* over overmap tiles, limited to a box around both ends.  Answers are kept
+// in om_routes until the overmaps around us change; a request from a point
+// along a remembered route to the same goal reuses the rest of that route.
+std::vector<point> game::om_route(point from, point to)
+{
+ std::vector<point> ret;
+ if (from.x == to.x && from.y == to.y)
+  return ret;
+ std::vector<int> stamp = om_route_stamp();
+ if (stamp != om_routes_stamp || om_routes.size() >= OM_ROUTE_CACHE) {
+  om_routes.clear();
+  om_routes_stamp = stamp;
+ }
+ const int span = OMAPY * 3;
+ std::pair<int, int> key((from.x + OMAPX) * span + from.y + OMAPY,
+                         (to.x + OMAPX) * span + to.y + OMAPY);
+ std::map<std::pair<int, int>, std::vector<point> >::iterator found =
+  om_routes.find(key);
+ if (found != om_routes.end())
+  return found->second;
+ for (found = om_routes.begin(); found != om_routes.end(); found++) {
+  if (found->first.second != key.second)
+   continue;
+  std::vector<point> &cached = found->second;
+  for (int i = 0; i + 1 < cached.size(); i++) {
+   if (cached[i].x == from.x && cached[i].y == from.y) {
+    ret.assign(cached.begin() + i + 1, cached.end());
+    om_routes[key] = ret;
+    return ret;
+   }
+  }
+ }
+
+ int minx = std::max(std::min(from.x, to.x) - OM_ROUTE_PAD, 0 - OMAPX),
+     miny = std::max(std::min(from.y, to.y) - OM_ROUTE_PAD, 0 - OMAPY),
+     maxx = std::min(std::max(from.x, to.x) + OM_ROUTE_PAD, OMAPX * 2 - 1),
+     maxy = std::min(std::max(from.y, to.y) + OM_ROUTE_PAD, OMAPY * 2 - 1);
+ if (from.x < minx || from.x > maxx || from.y < miny || from.y > maxy ||
+     to.x < minx || to.x > maxx || to.y < miny || to.y > maxy ||
+     om_travel_cost(to.x, to.y) == 0) {
+  om_routes[key] = ret;
+  return ret;
+ }
+ int w = maxx - minx + 1, h = maxy - miny + 1;
+// cost is -1 until read, and dist 0 until reached; parent indexes the window
+ std::vector<int> cost(w * h, -1), dist(w * h, 0), parent(w * h, -1);
+ std::priority_queue<pursuit_node> open;
+ int start = (from.x - minx) * h + from.y - miny,
+     goal  = (to.x - minx) * h + to.y - miny;
+ dist[start] = 1;
+ open.push(pursuit_node(rl_dist(from.x, from.y, to.x, to.y), from.x, from.y));
+ while (!open.empty()) {
+  pursuit_node cur = open.top();
+  open.pop();
+  int here = (cur.x - minx) * h + cur.y - miny;
+  if (here == goal)
+   break;
+  if (cur.dist > dist[here] - 1 + rl_dist(cur.x, cur.y, to.x, to.y))
+   continue;	// Stale entry
+  for (int i = -1; i <= 1; i++) {
+   for (int j = -1; j <= 1; j++) {
+    int x = cur.x + i, y = cur.y + j;
+    if ((i == 0 && j == 0) || x < minx || x > maxx || y < miny || y > maxy)
+     continue;
+    int next = (x - minx) * h + y - miny;
+    if (cost[next] == -1)
+     cost[next] = om_travel_cost(x, y);
+    if (cost[next] == 0)
+     continue;
+    int newdist = dist[here] + cost[next];
+    if (dist[next] == 0 || newdist < dist[next]) {
+     dist[next] = newdist;
+     parent[next] = here;
+     open.push(pursuit_node(newdist - 1 + rl_dist(x, y, to.x, to.y), x, y));
+    }
+   }
+  }
+ }
+ if (parent[goal] != -1) {
+  for (int cur = goal; cur != start; cur = parent[cur])
+   ret.push_back(point(minx + cur / h, miny + cur % h));
+  std::reverse(ret.begin(), ret.end());
+ }
+ om_routes[key] = ret;
+ return ret;
+}
+
 bool game::is_game_over()
 {
  if (uquit != QUIT_NO)
@@ -1424,6 +1709,7 @@ void game::load(std::string name)
  std::stringstream playerfile;
  playerfile << "save/" << name << ".sav";
  fin.open(playerfile.str().c_str());
+ pursuit_turn = -1;
 // First, read in basic game state information.
  if (!fin.is_open()) {
   debugmsg("No save game exists!");
@@ -1439,8 +1725,10 @@ void game::load(std::string name)
         next_faction_id >> next_mission_id >> tmpspawn >> tmpnextweather >>
         tmpweather >> tmptemp >> levx >> levy >> levz >> comx >> comy;
  turn = tmpturn;
+ events.reset(tmpturn);
  nextspawn = tmpspawn;
  nextweather = tmpnextweather;
+ schedule_tasks();
  cur_om = overmap(this, comx, comy, levz);
 // m = map(&itypes, &mapitems, &traps); // Init the root map with our vectors
  m.load(this, levx, levy);
@@ -1493,6 +1781,12 @@ void game::load(std::string name)
     u.worn.push_back(item(itemdata, this));
    else if (item_place == 'w')
     u.weapon = item(itemdata, this);
+   else if (item_place == 'E') {
+    std::stringstream evdata(itemdata);
+    int evtype, evturn, evfac, evx, evy;
+    evdata >> evtype >> evturn >> evfac >> evx >> evy;
+    events.add(event(event_type(evtype), evturn, evfac, evx, evy));
+   }
    else if (item_place == 'c')
     u.weapon.contents.push_back(item(itemdata, this));
   }
@@ -1529,8 +1823,13 @@ void game::save()
   fout << z[i].save_info() << std::endl;
  for (int i = 0; i < num_monsters; i++)	// Save the kill counts, too.
   fout << kills[i] << " ";
-// And finally the player.
+// And finally the player, and the events still to come.
  fout << u.save_info() << std::endl;
+ std::vector<event> pending = events.list();
+ for (int i = 0; i < pending.size(); i++)
+  fout << "E " << int(pending[i].type) << " " << pending[i].turn << " " <<
+          pending[i].faction_id << " " << pending[i].map_point.x << " " <<
+          pending[i].map_point.y << std::endl;
  fout << std::endl;
  fout.close();
 // Now write things that aren't player-specific: factions and NPCs
@@ -1590,16 +1889,12 @@ void game::add_msg(const char* msg, ...)
 void game::add_event(event_type type, int on_turn, int faction_id, int x, int y)
 {
  event tmp(type, on_turn, faction_id, x, y);
- events.push_back(tmp);
+ events.add(tmp);
 }
 
 bool game::event_queued(event_type type)
 {
- for (int i = 0; i < events.size(); i++) {
-  if (events[i].type == type)
-   return true;
-  }
-  return false;
+ return events.has(type);
 }
 
 void game::debug()
@@ -1653,6 +1948,7 @@ void game::debug()
    point tmp = cur_om.choose_point(this);
    if (tmp.x != -1) {
     z.clear();
+    sounds.clear();
     m.save(&cur_om, turn, levx, levy);
     levx = tmp.x * 2 - int(MAPSIZE / 2);
     levy = tmp.y * 2 - int(MAPSIZE / 2);
@@ -1687,9 +1983,11 @@ void game::debug()
 Location %d:%d in %d:%d, %s\n\
 Current turn: %d; Next spawn %d.\n\
 %d monsters exist.\n\
-%d events planned.", u.posx, u.posy, levx, levy,
+%d events planned.\n\
+%d of %d sight checks answered from memo.", u.posx, u.posy, levx, levy,
 oterlist[cur_om.ter(levx / 2, levy / 2)].name.c_str(),
-int(turn), int(nextspawn), z.size(), events.size());
+int(turn), int(nextspawn), z.size(), events.size(),
+m.los_hits, m.los_hits + m.los_misses);
    if (!active_npc.empty())
     popup_top("\%s: %d:%d (you: %d:%d)", active_npc[0].name.c_str(),
               active_npc[0].posx, active_npc[0].posy, u.posx, u.posy);
@@ -1748,7 +2046,9 @@ void game::groupdebug()
  mvprintw(0, 0, "OM %d : %d    M %d : %d", cur_om.posx, cur_om.posy, levx,
                                            levy);
  int dist, linenum = 1;
- for (int i = 0; i < cur_om.zg.size(); i++) {
+ std::vector<int> nearby = cur_om.mongroups_near(levx, levy);
+ for (int n = 0; n < nearby.size(); n++) {
+  int i = nearby[n];
   dist = trig_dist(levx, levy, cur_om.zg[i].posx, cur_om.zg[i].posy);
   if (dist <= cur_om.zg[i].radius) {
    mvprintw(linenum, 0, "Zgroup %d: Centered at %d:%d, radius %d, pop %d",
@@ -2094,7 +2394,7 @@ void game::draw()
   col_temp = c_ltblue;
  wprintz(w_status, col_temp, " %dF", temperature);
  mvwprintz(w_status, 0, 41, c_white, "%s, day %d",
-           season_name[turn.season].c_str(), turn.day + 1);
+           season_name[turn.season()].c_str(), turn.day() + 1);
  if (run_mode != 0)
   mvwprintz(w_status, 2, 51, c_red, "SAFE");
  wrefresh(w_status);
@@ -2352,7 +2652,7 @@ unsigned char game::light_level()
 {
  int ret;
 /*
- debugmsg("mins: %d hour: %d past midnight: %d", turn.minute, turn.hour,
+ debugmsg("mins: %d hour: %d past midnight: %d", turn.minute(), turn.hour(),
           turn.minutes_past_midnight());
 */
  if (levz < 0)	// Underground!
@@ -2462,7 +2762,7 @@ bool game::u_see(int x, int y, int &t)
   if (rl_dist(u.posx, u.posy, x, y) <= crange)
    return true;
  }
- return m.sees(u.posx, u.posy, x, y, range, t);
+ return m.pl_sees(u.posx, u.posy, x, y, range);
 }
 
 bool game::u_see(monster *mon, int &t)
@@ -2479,7 +2779,7 @@ bool game::u_see(monster *mon, int &t)
   if (dist <= crange)
    return true;
  }
- return m.sees(u.posx, u.posy, mon->posx, mon->posy, range, t);
+ return m.pl_sees(u.posx, u.posy, mon->posx, mon->posy, range);
 }
 
 bool game::pl_sees(player *p, monster *mon, int &t)
@@ -2488,70 +2788,138 @@ bool game::pl_sees(player *p, monster *mon, int &t)
      rl_dist(p->posx, p->posy, mon->posx, mon->posy) > 1)
   return false;	// Can't see digging monsters until we're right next to them
  int range = p->sight_range(light_level());
- return m.sees(p->posx, p->posy, mon->posx, mon->posy, range, t);
+ m.sight_from(p->posx, p->posy, range);
+ return m.in_sight(mon->posx, mon->posy);
 }
 
-point game::find_item(item *it)
+// Carried items are short lists, so check those before the map.  Whoever we
+// find it with goes in item_owners, and next time we look there first; items
+// move around by value, so that's only ever a hint, and owner_has() checks it.
+bool game::locate_item(item *it, item_owner &owner)
 {
+ std::map<item*, item_owner>::iterator hint = item_owners.find(it);
+ if (hint != item_owners.end()) {
+  if (owner_has(it, hint->second)) {
+   owner = hint->second;
+   return true;
+  }
+  item_owners.erase(hint);
+ }
  if (u.has_item(it))
-  return point(u.posx, u.posy);
- point ret = m.find_item(it);
- if (ret.x != -1 && ret.y != -1)
-  return ret;
- for (int i = 0; i < active_npc.size(); i++) {
-  for (int j = 0; j < active_npc[i].inv.size(); j++) {
-   if (it == &(active_npc[i].inv[j]))
-    return point(active_npc[i].posx, active_npc[i].posy);
+  owner = item_owner(IO_PLAYER);
+ else {
+  owner.type = IO_MAP;
+  for (int i = 0; i < active_npc.size() && owner.type == IO_MAP; i++) {
+   if (active_npc[i].has_item(it))
+    owner = item_owner(IO_NPC, active_npc[i].id);
+  }
+ }
+ if (owner.type == IO_MAP) {
+  point p = m.find_item(it);
+  if (p.x != -1 && p.y != -1)
+   owner = item_owner(IO_MAP, -1, p);
+  else {
+   int part;
+   p = m.find_vehicle_item(it, part);
+   if (p.x == -1 && p.y == -1)
+    return false;
+   owner = item_owner(IO_VEHICLE, -1, p, part);
   }
  }
- return point(-999, -999);
+// The map keeps its own hints for the ground, and checking ours is no cheaper
+ if (owner.type != IO_MAP)
+  item_owners[it] = owner;
+ return true;
 }
 
-void game::remove_item(item *it)
+bool game::owner_has(item *it, item_owner &owner)
 {
- point ret;
- if (it == &u.weapon) {
-  u.remove_weapon();
-  return;
- }
- for (int i = 0; i < u.inv.size(); i++) {
-  if (it == &u.inv[i]) {
-   u.i_remn(i);
-   return;
+ switch (owner.type) {
+ case IO_PLAYER:
+  return u.has_item(it);
+ case IO_NPC:
+  for (int i = 0; i < active_npc.size(); i++) {
+   if (active_npc[i].id == owner.npc_id)
+    return active_npc[i].has_item(it);
   }
+  return false;
+ case IO_MAP:
+  return false;	// Never stored
+ case IO_VEHICLE: {
+  vehicle &veh = m.veh_at(owner.pos.x, owner.pos.y);
+  if (veh.type == veh_null || owner.part >= veh.parts.size())
+   return false;
+  std::vector<item> &cargo = veh.parts[owner.part].items;
+  std::less<const item*> before;
+  return (!cargo.empty() && !before(it, &(cargo[0])) &&
+          !before(&(cargo.back()), it));
  }
- for (int i = 0; i < u.worn.size(); i++) {
-  if (it == &u.worn[i]) {
-   u.worn.erase(u.worn.begin() + i);
-   return;
-  }
  }
- ret = m.find_item(it);
- if (ret.x != -1 && ret.y != -1) {
-  for (int i = 0; i < m.i_at(ret.x, ret.y).size(); i++) {
-   if (it == &m.i_at(ret.x, ret.y)[i]) {
-    m.i_rem(ret.x, ret.y, i);
-    return;
-   }
-  }
+ return false;
+}
+
+point game::find_item(item *it)
+{
+ item_owner owner;
+ if (!locate_item(it, owner))
+  return point(-999, -999);
+ if (owner.type == IO_PLAYER)
+  return point(u.posx, u.posy);
+ if (owner.type == IO_NPC) {
+  npc *p = find_npc(owner.npc_id);
+  return point(p->posx, p->posy);
  }
- for (int i = 0; i < active_npc.size(); i++) {
-  if (it == &active_npc[i].weapon) {
-   active_npc[i].remove_weapon();
+ return owner.pos;
+}
+
+// Takes it out of a carried inventory; p has to have it
+static void remove_carried(player &p, item *it)
+{
+ if (it == &p.weapon) {
+  p.remove_weapon();
+  return;
+ }
+ for (int i = 0; i < p.worn.size(); i++) {
+  if (it == &p.worn[i]) {
+   p.worn.erase(p.worn.begin() + i);
    return;
   }
-  for (int j = 0; j < active_npc[i].inv.size(); j++) {
-   if (it == &active_npc[i].inv[j]) {
-    active_npc[i].i_remn(j);
+ }
+ for (int i = 0; i < p.inv.size(); i++) {
+  for (int j = 0; j < p.inv.stack_at(i).size(); j++) {
+   if (it == &p.inv.stack_at(i)[j]) {
+    p.inv.remove_item(i, j);
     return;
    }
   }
-  for (int j = 0; j < active_npc[i].worn.size(); j++) {
-   if (it == &active_npc[i].worn[j]) {
-    active_npc[i].worn.erase(active_npc[i].worn.begin() + j);
-    return;
+ }
+}
+
+void game::remove_item(item *it)
+{
+ item_owner owner;
+ if (!locate_item(it, owner))
+  return;
+ item_owners.erase(it);
+ switch (owner.type) {
+ case IO_PLAYER:
+  remove_carried(u, it);
+  break;
+ case IO_NPC:
+  remove_carried(*find_npc(owner.npc_id), it);
+  break;
+ case IO_MAP:
+  for (int i = 0; i < m.i_at(owner.pos.x, owner.pos.y).size(); i++) {
+   if (it == &m.i_at(owner.pos.x, owner.pos.y)[i]) {
+    m.i_rem(owner.pos.x, owner.pos.y, i);
+    break;
    }
   }
+  break;
+ case IO_VEHICLE: {
+  vehicle &veh = m.veh_at(owner.pos.x, owner.pos.y);
+  veh.remove_item(owner.part, it - &(veh.parts[owner.part].items[0]));
+ } break;
  }
 }
 
@@ -2687,6 +3055,38 @@ void game::mon_info()
  refresh();
 }
 
+// One monster's or NPC's claim on the next action; whoever has the most moves
+// left goes first, ties in the order they were queued
+struct turn_entry {
+ int moves, seq, index, who; // who: the monster's turn_stamp or the NPC's id
+ bool is_npc;
+ turn_entry(int M, int S, int I, int W, bool N) :
+  moves (M), seq (S), index (I), who (W), is_npc (N) {}
+ bool operator< (const turn_entry &b) const
+ {
+  return (moves < b.moves || (moves == b.moves && seq > b.seq));
+ }
+};
+
+// The friendly monsters hostile ones will go after, by index into z; built
+// once per queue, so activity() and plan() needn't search all of z each
+static void find_friends(std::vector<monster> &z, std::vector<int> &friends)
+{
+ friends.clear();
+ for (int i = 0; i < z.size(); i++) {
+  if (z[i].friendly != 0)
+   friends.push_back(i);
+ }
+}
+
+// Monsters and NPCs take their actions one at a time from a single queue, so
+// a fast monster's extra actions are spread across the turn instead of all
+// coming before anyone slower can react.  The player has already acted.
+// Bookkeeping comes first for everyone: every monster is unstuck, has its
+// effects ticked and may die of them, and every NPC is reset() and suffer()s,
+// before anybody takes an action.  (Each used to get this just before its
+// own moves, so an earlier monster's attack could land before a later one's
+// effects ticked.)
 void game::monmove()
 {
  for (int i = 0; i < z.size(); i++) {
@@ -2724,53 +3124,20 @@ void game::monmove()
     dead = true;
    }
   }
-  while (z[i].moves > 0 && !dead) {
-   z[i].made_footstep = false;
-   z[i].plan(this);	// Formulate a path to follow
-   z[i].move(this);	// Move one square, possibly hit u
-   m.mon_in_field(z[i].posx, z[i].posy, this, &(z[i]));
-   if (z[i].hurt(0)) {	// Maybe we died...
-    kill_mon(i);
-    dead = true;
-   }
-  }
   if (dead)
    i--;
-  else {
-   if (in_tutorial && u.pain > 0)
-    tutorial_message(LESSON_PAIN);
-   if (u.has_active_bionic(bio_alarm) && u.power_level >= 1 &&
-       abs(z[i].posx - u.posx) <= 5 && abs(z[i].posy - u.posy) <= 5) {
-    u.power_level--;
-    add_msg("Your motion alarm goes off!");
-    u.activity.type = ACT_NULL;
-    if (u.has_disease(DI_SLEEP) || u.has_disease(DI_LYING_DOWN)) {
-     u.rem_disease(DI_SLEEP);
-     u.rem_disease(DI_LYING_DOWN);
-    }
-   }
-// We might have stumbled out of range of the player; if so, delete us
-   if (z[i].posx < 0 - SEEX || z[i].posy < 0 - SEEY ||
-       z[i].posx > SEEX * (MAPSIZE + 1) || z[i].posy > SEEY * (MAPSIZE + 1)) {
-    int group = valid_group((mon_id)(z[i].type->id), levx, levy);
-    if (group != -1) {
-     cur_om.zg[group].population++;
-     if (cur_om.zg[group].population / pow(cur_om.zg[group].radius, 2.0) > 5)
-      cur_om.zg[group].radius++;
-    } else if (mt_to_mc((mon_id)(z[i].type->id)) != mcat_null) {
-     cur_om.zg.push_back(mongroup(mt_to_mc((mon_id)(z[i].type->id)),
-                                  levx, levy, 1, 1));
-    }
-    z.erase(z.begin()+i);
-    i--;
-   } else
-    z[i].receive_moves();
-  }
+ }
+// Monsters with nothing to react to only act every few turns; see activity().
+// dormant_turns stays above 0 while we're sitting this turn out.
+ std::vector<int> friends;
+ find_friends(z, friends);
+ for (int i = 0; i < z.size(); i++) {
+  if (z[i].activity(this, friends) != MA_DORMANT ||
+      ++z[i].dormant_turns >= MON_DORMANT_TURNS)
+   z[i].dormant_turns = 0;
  }
 
-// Now, do active NPCs.
  for (int i = 0; i < active_npc.size(); i++) {
-  int turns = 0;
   if(active_npc[i].hp_cur[hp_head] <= 0 || active_npc[i].hp_cur[hp_torso] <= 0){
    active_npc[i].die(this);
    active_npc.erase(active_npc.begin() + i);
@@ -2778,17 +3145,134 @@ void game::monmove()
   } else {
    active_npc[i].reset(this);
    active_npc[i].suffer(this);
-   while (active_npc[i].moves > 0 && turns < 10) {
-    turns++;
-    active_npc[i].move(this);
+  }
+ }
+
+ std::map<int, int> npc_turns;	// Actions taken, by NPC id
+ std::priority_queue<turn_entry> queue;
+ int seq = 0, zsize = -1, npcsize = -1, stamp = 0;
+ bool stale = true;
+ while (true) {
+// Someone died or arrived, so the indices we queued are off; queue afresh.
+// Every monster gets a fresh stamp, so an entry can tell if its index has
+// since come to hold someone else.
+  if (stale || z.size() != zsize || active_npc.size() != npcsize) {
+   stale = false;
+   zsize = z.size();
+   npcsize = active_npc.size();
+   queue = std::priority_queue<turn_entry>();
+   find_friends(z, friends);
+   for (int i = 0; i < zsize; i++) {
+    z[i].turn_stamp = ++stamp;
+    if (z[i].moves > 0 && z[i].dormant_turns == 0)
+     queue.push(turn_entry(z[i].moves, seq++, i, stamp, false));
    }
-   if (turns == 10) {
-    add_msg("%s's brain explodes!", active_npc[i].name.c_str());
-    active_npc[i].die(this);
-    active_npc.erase(active_npc.begin() + i);
-    i--;
+   for (int i = 0; i < npcsize; i++) {
+    if (active_npc[i].moves > 0 && npc_turns[active_npc[i].id] < 10)
+     queue.push(turn_entry(active_npc[i].moves, seq++, i, active_npc[i].id,
+                           true));
+   }
+  }
+  if (queue.empty())
+   break;
+  turn_entry next = queue.top();
+  queue.pop();
+  if (next.is_npc ? active_npc[next.index].id != next.who :
+                    z[next.index].turn_stamp != next.who) {
+   stale = true;	// Not who we queued
+   continue;
+  }
+  int moves = (next.is_npc ? active_npc[next.index].moves :
+                             z[next.index].moves);
+  if (moves <= 0)
+   continue;
+  if (moves != next.moves) {	// Spent or gained moves since being queued
+   next.moves = moves;
+   next.seq = seq++;
+   queue.push(next);
+   continue;
+  }
+  if (next.is_npc) {
+   npc *p = &(active_npc[next.index]);
+   if (p->hp_cur[hp_head] <= 0 || p->hp_cur[hp_torso] <= 0)
+    continue;	// Died this turn; we'll clean up after them below
+   npc_turns[next.who]++;
+   p->move(this);
+  } else {
+   int i = next.index;
+   z[i].made_footstep = false;
+   z[i].plan(this, friends);	// Formulate a path to follow
+   z[i].move(this);	// Move one square, possibly hit u
+// Moving can kill or spawn monsters, so we may not be at i any more
+   if (i >= z.size() || z[i].turn_stamp != next.who) {
+    for (i = 0; i < z.size() && z[i].turn_stamp != next.who; i++)
+     ;
+   }
+   if (i < z.size()) {
+    m.mon_in_field(z[i].posx, z[i].posy, this, &(z[i]));
+    if (z[i].hurt(0))	// Maybe we died...
+     kill_mon(i);
    }
   }
+// Back in the queue if we're still where we were; otherwise it's rebuilt
+  if (z.size() != zsize || active_npc.size() != npcsize)
+   continue;
+  if (next.is_npc ? active_npc[next.index].id != next.who :
+                    z[next.index].turn_stamp != next.who) {
+   stale = true;
+   continue;
+  }
+  moves = (next.is_npc ? active_npc[next.index].moves :
+                         z[next.index].moves);
+  if (moves > 0 && (!next.is_npc || npc_turns[next.who] < 10)) {
+   next.moves = moves;
+   next.seq = seq++;
+   queue.push(next);
+  }
+ }
+
+ for (int i = 0; i < z.size(); i++) {
+  if (in_tutorial && u.pain > 0)
+   tutorial_message(LESSON_PAIN);
+  if (u.has_active_bionic(bio_alarm) && u.power_level >= 1 &&
+      abs(z[i].posx - u.posx) <= 5 && abs(z[i].posy - u.posy) <= 5) {
+   u.power_level--;
+   add_msg("Your motion alarm goes off!");
+   u.activity.type = ACT_NULL;
+   if (u.has_disease(DI_SLEEP) || u.has_disease(DI_LYING_DOWN)) {
+    u.rem_disease(DI_SLEEP);
+    u.rem_disease(DI_LYING_DOWN);
+   }
+  }
+// We might have stumbled out of range of the player; if so, delete us
+  if (z[i].posx < 0 - SEEX || z[i].posy < 0 - SEEY ||
+      z[i].posx > SEEX * (MAPSIZE + 1) || z[i].posy > SEEY * (MAPSIZE + 1)) {
+   int group = valid_group((mon_id)(z[i].type->id), levx, levy);
+   if (group != -1) {
+    cur_om.zg[group].population++;
+    if (cur_om.zg[group].population / pow(cur_om.zg[group].radius, 2.0) > 5)
+     cur_om.grow_mongroup(group);
+   } else if (mt_to_mc((mon_id)(z[i].type->id)) != mcat_null) {
+    cur_om.zg.push_back(mongroup(mt_to_mc((mon_id)(z[i].type->id)),
+                                 levx, levy, 1, 1));
+   }
+   z.erase(z.begin()+i);
+   i--;
+  } else if (z[i].dormant_turns == 0)
+   z[i].receive_moves();
+ }
+
+ for (int i = 0; i < active_npc.size(); i++) {
+  if(active_npc[i].hp_cur[hp_head] <= 0 || active_npc[i].hp_cur[hp_torso] <= 0){
+   active_npc[i].die(this);
+   active_npc.erase(active_npc.begin() + i);
+   i--;
+  } else if (npc_turns[active_npc[i].id] == 10 && active_npc[i].moves > 0) {
+   add_msg("%s's brain explodes!", active_npc[i].name.c_str());
+   active_npc[i].die(this);
+   active_npc.erase(active_npc.begin() + i);
+   i--;
+  }
  }
 }
 
@@ -2886,15 +3370,19 @@ void game::check_warmth()
 void game::sound(int x, int y, int vol, std::string description)
 {
  vol *= 1.5; // Scale it a little
-// First, alert all monsters (that can hear) to the sound
- for (int i = 0; i < z.size(); i++) {
-  if (z[i].can_hear()) {
-   int dist = rl_dist(x, y, z[i].posx, z[i].posy);
-   if (z[i].has_flag(MF_GOODHEARING) && int(dist / 2) <= vol)
-    z[i].wander_to(x, y, vol - int(dist / 2));
-   else if (dist <= vol && dist >= 2) // Adjacent sounds are this monster
-    z[i].wander_to(x, y, vol - dist);
+// First, queue it for monsters; they all hear it in process_sounds()
+ if (vol > 0 && x >= 0 && x < SEEX * MAPSIZE &&
+                y >= 0 && y < SEEY * MAPSIZE) {
+  bool merged = false;
+  for (int i = 0; i < sounds.size() && !merged; i++) {
+   if (sounds[i].x == x && sounds[i].y == y) {
+    if (sounds[i].vol < vol)
+     sounds[i].vol = vol;
+    merged = true;
+   }
   }
+  if (!merged)
+   sounds.push_back(sound_event(x, y, vol));
  }
 // Loud sounds make the next spawn sooner!
  int spawn_range = int(MAPSIZE / 2) * SEEX;
@@ -2910,6 +3398,7 @@ void game::sound(int x, int y, int vol, std::string description)
    nextspawn = 0;
   else
    nextspawn -= change;
+  schedule_spawn_check();
  }
 // Next, display the sound as the player hears it
  if (description == "")
@@ -3009,6 +3498,11 @@ void game::explosion(int x, int y, int power, int shrapnel, bool fire)
   sound(x, y, power * 10, "a huge explosion!");
  else
   sound(x, y, power * 10, "an explosion!");
+// Most blasts catch nobody; don't look for victims tile by tile if so
+ bool any_mons = !mons_in_rect(x - radius, y - radius,
+                               x + radius, y + radius).empty(),
+      any_npcs = !npcs_in_rect(x - radius, y - radius,
+                               x + radius, y + radius).empty();
  for (int i = x - radius; i <= x + radius; i++) {
   for (int j = y - radius; j <= y + radius; j++) {
    if (i == x && j == y)
@@ -3022,7 +3516,8 @@ void game::explosion(int x, int y, int power, int shrapnel, bool fire)
    if (m.is_destructable(i, j) && rng(25, 100) < dam)
     m.destroy(this, i, j, false);
 
-   int mon_hit = mon_at(i, j), npc_hit = npc_at(i, j);
+   int mon_hit = (any_mons ? mon_at(i, j) : -1),
+       npc_hit = (any_npcs ? npc_at(i, j) : -1);
    if (mon_hit != -1 && z[mon_hit].hurt(rng(dam / 2, dam * 1.5))) {
     if (z[mon_hit].hp < 0 - 1.5 * z[mon_hit].type->hp)
      explode_mon(mon_hit); // Explode them if it was big overkill
@@ -3057,8 +3552,10 @@ void game::explosion(int x, int y, int power, int shrapnel, bool fire)
     u.hit(this, bp_arms,  1, rng(dam / 3, dam),       0);
    }
    if (fire) {
-    if (m.field_at(i, j).type == fd_smoke)
+    if (m.field_at(i, j).type == fd_smoke) {
      m.field_at(i, j) = field(fd_fire, 1, 0);
+     m.touch_tile(i, j);
+    }
     m.add_field(this, i, j, fd_fire, dam / 10);
    }
   }
@@ -3210,8 +3707,10 @@ void game::resonance_cascade(int x, int y)
        case 6:
        case 7: type = fd_nuke_gas;
       }
-      if (m.field_at(k, l).type == fd_null || !one_in(3))
-       m.field_at(k, l) = field(type, 3, 0);
+      if (m.field_at(k, l).type == fd_null || !one_in(3)) {
+       m.remove_field(k, l);
+       m.add_field(NULL, k, l, type, 3);
+      }
      }
     }
     break;
@@ -3251,7 +3750,7 @@ void game::emp_blast(int x, int y)
  int rn;
  if (m.has_flag(console, x, y)) {
   add_msg("The %s is rendered non-functional!", m.tername(x, y).c_str());
-  m.ter(x, y) = t_console_broken;
+  m.ter_set(x, y, t_console_broken);
   return;
  }
 // TODO: More terrain effects.
@@ -3261,14 +3760,14 @@ void game::emp_blast(int x, int y)
   rn = rng(1, 100);
   if (rn > 92 || rn < 40) {
    add_msg("The card reader is rendered non-functional.");
-   m.ter(x, y) = t_card_reader_broken;
+   m.ter_set(x, y, t_card_reader_broken);
   }
   if (rn > 80) {
    add_msg("The nearby doors slide open!");
    for (int i = -3; i <= 3; i++) {
     for (int j = -3; j <= 3; j++) {
      if (m.ter(x + i, y + j) == t_door_metal_locked)
-      m.ter(x + i, y + j) = t_floor;
+      m.ter_set(x + i, y + j, t_floor);
     }
    }
   }
@@ -3314,6 +3813,140 @@ int game::npc_at(int x, int y)
  return -1;
 }
 
+bool game::fast_forward()
+{
+ if (!u.has_disease(DI_SLEEP) && u.activity.type != ACT_WAIT &&
+     u.activity.type != ACT_CRAFT && u.activity.type != ACT_READ)
+  return false;
+ if (!sounds.empty() || m.fields_near(u.posx, u.posy, FF_RANGE))
+  return false;
+ for (int i = 0; i < z.size(); i++) {
+  if (rl_dist(u.posx, u.posy, z[i].posx, z[i].posy) <= FF_RANGE)
+   return false;
+ }
+ for (int i = 0; i < active_npc.size(); i++) {
+  if (rl_dist(u.posx, u.posy, active_npc[i].posx, active_npc[i].posy) <=
+      FF_RANGE)
+   return false;
+ }
+ return true;
+}
+
+// Floods outward from each of this turn's sounds, losing volume to distance and
+// terrain, and sends every monster towards the loudest one it heard
+void game::process_sounds()
+{
+ if (sounds.empty())
+  return;
+ const int mapw = SEEX * MAPSIZE, maph = SEEY * MAPSIZE;
+ bool listeners = false;
+ int hearing = 1;	// 2 if anyone has good hearing
+ for (int x = 0; x < mapw; x++) {
+  for (int y = 0; y < maph; y++)
+   sound_mon[x][y] = -1;
+ }
+ for (int i = 0; i < z.size(); i++) {
+  if (z[i].can_hear() && z[i].posx >= 0 && z[i].posx < mapw &&
+      z[i].posy >= 0 && z[i].posy < maph) {
+   sound_mon[z[i].posx][z[i].posy] = i;
+   listeners = true;
+   if (z[i].has_flag(MF_GOODHEARING))
+    hearing = 2;
+  }
+ }
+ if (!listeners) {
+  sounds.clear();
+  return;
+ }
+// Listeners by submap, so each sound only looks at the ones near it
+ std::vector<int> near[MAPSIZE * MAPSIZE];
+ for (int i = 0; i < z.size(); i++) {
+  if (z[i].posx >= 0 && z[i].posx < mapw && z[i].posy >= 0 &&
+      z[i].posy < maph && sound_mon[z[i].posx][z[i].posy] == i)
+   near[z[i].posx / SEEX + (z[i].posy / SEEY) * MAPSIZE].push_back(i);
+ }
+
+ std::vector<int> heard(z.size(), -1), from(z.size(), -1);
+ for (int s = 0; s < sounds.size(); s++) {
+  int sx = sounds[s].x, sy = sounds[s].y, vol = sounds[s].vol;
+// Only spread as far as the furthest listener in range needs; good hearing
+// picks up sounds from twice as far.  Once they've all been reached, stop.
+  int reach = -1, pending = 0;
+  int far = vol * hearing;
+  int smx1 = (sx - far < 0 ? 0 : (sx - far) / SEEX);
+  int smy1 = (sy - far < 0 ? 0 : (sy - far) / SEEY);
+  int smx2 = (sx + far >= mapw ? MAPSIZE - 1 : (sx + far) / SEEX);
+  int smy2 = (sy + far >= maph ? MAPSIZE - 1 : (sy + far) / SEEY);
+  for (int smx = smx1; smx <= smx2; smx++) {
+   for (int smy = smy1; smy <= smy2; smy++) {
+    std::vector<int> &here = near[smx + smy * MAPSIZE];
+    for (int n = 0; n < here.size(); n++) {
+     int i = here[n];
+     int range = (z[i].has_flag(MF_GOODHEARING) ? vol * 2 : vol);
+     if (rl_dist(sx, sy, z[i].posx, z[i].posy) <= range) {
+      pending++;
+      if (range > reach)
+       reach = range;
+     }
+    }
+   }
+  }
+  if (pending == 0)
+   continue;
+  int x1 = (sx - reach < 0 ? 0 : sx - reach);
+  int y1 = (sy - reach < 0 ? 0 : sy - reach);
+  int x2 = (sx + reach >= mapw ? mapw - 1 : sx + reach);
+  int y2 = (sy + reach >= maph ? maph - 1 : sy + reach);
+  for (int x = x1; x <= x2; x++) {
+   for (int y = y1; y <= y2; y++)
+    sound_dist[x][y] = reach + 1;
+  }
+// Every step costs at least 1, so bucket squares by volume lost so far
+  std::vector< std::vector<point> > frontier(reach + 1);
+  sound_dist[sx][sy] = 0;
+  frontier[0].push_back(point(sx, sy));
+  for (int d = 0; d <= reach && pending > 0; d++) {
+   for (int n = 0; n < frontier[d].size() && pending > 0; n++) {
+    int x = frontier[d][n].x, y = frontier[d][n].y;
+    if (sound_dist[x][y] != d)
+     continue;	// Reached more cheaply since
+    int i = sound_mon[x][y];
+    if (i != -1) {
+     int hear = -1;
+     bool good = z[i].has_flag(MF_GOODHEARING);
+     if (good)
+      hear = vol - d / 2;
+     else if (d <= vol && rl_dist(sx, sy, x, y) >= 2) // Adjacent is this monster
+      hear = vol - d;
+     if (hear > heard[i]) {
+      heard[i] = hear;
+      from[i] = s;
+     }
+     if (rl_dist(sx, sy, x, y) <= (good ? vol * 2 : vol))
+      pending--;
+    }
+    for (int nx = x - 1; nx <= x + 1; nx++) {
+     for (int ny = y - 1; ny <= y + 1; ny++) {
+      if (nx < x1 || nx > x2 || ny < y1 || ny > y2)
+       continue;
+      int cost = (m.move_cost(nx, ny) > 0 ? 1 :
+                  (m.trans(nx, ny) ? SOUND_WINDOW : SOUND_WALL));
+      if (d + cost < sound_dist[nx][ny]) {
+       sound_dist[nx][ny] = d + cost;
+       frontier[d + cost].push_back(point(nx, ny));
+      }
+     }
+    }
+   }
+  }
+ }
+ for (int i = 0; i < z.size(); i++) {
+  if (from[i] != -1)
+   z[i].wander_to(sounds[from[i]].x, sounds[from[i]].y, heard[i]);
+ }
+ sounds.clear();
+}
+
 int game::mon_at(int x, int y)
 {
  for (int i = 0; i < z.size(); i++) {
@@ -3323,6 +3956,27 @@ int game::mon_at(int x, int y)
  return -1;
 }
 
+std::vector<int> game::npcs_in_rect(int x1, int y1, int x2, int y2)
+{
+ std::vector<int> ret;
+ for (int i = 0; i < active_npc.size(); i++) {
+  if (active_npc[i].posx >= x1 && active_npc[i].posx <= x2 &&
+      active_npc[i].posy >= y1 && active_npc[i].posy <= y2)
+   ret.push_back(i);
+ }
+ return ret;
+}
+
+std::vector<int> game::mons_in_rect(int x1, int y1, int x2, int y2)
+{
+ std::vector<int> ret;
+ for (int i = 0; i < z.size(); i++) {
+  if (z[i].posx >= x1 && z[i].posx <= x2 && z[i].posy >= y1 && z[i].posy <= y2)
+   ret.push_back(i);
+ }
+ return ret;
+}
+
 bool game::is_empty(int x, int y)
 {
  return (m.move_cost(x, y) > 0 && npc_at(x, y) == -1 && mon_at(x, y) == -1 &&
@@ -3414,9 +4068,10 @@ void game::explode_mon(int index)
     else if (corpse->dies == &mdeath::acid)
      blood_type = fd_acid;
     if (m.field_at(tarx, tary).type == blood_type &&
-        m.field_at(tarx, tary).density < 3)
+        m.field_at(tarx, tary).density < 3) {
      m.field_at(tarx, tary).density++;
-    else
+     m.touch_tile(tarx, tary);
+    } else
      m.add_field(this, tarx, tary, blood_type, 1);
 
     if (m.move_cost(tarx, tary) == 0) {
@@ -3829,7 +4484,7 @@ void game::examine()
    for (int i = -3; i <= 3; i++) {
     for (int j = -3; j <= 3; j++) {
      if (m.ter(examx + i, examy + j) == t_door_metal_locked)
-      m.ter(examx + i, examy + j) = t_floor;
+      m.ter_set(examx + i, examy + j, t_floor);
     }
    }
    for (int i = 0; i < z.size(); i++) {
@@ -3870,17 +4525,17 @@ void game::examine()
        u.charge_power(0 - rng(0, u.power_level));
       }
      }
-     m.ter(examx, examy) = t_card_reader_broken;
+     m.ter_set(examx, examy, t_card_reader_broken);
     } else if (success < 6)
      add_msg("Nothing happens.");
     else {
      add_msg("You activate the panel!");
      add_msg("The nearby doors slide into the floor.");
-     m.ter(examx, examy) = t_card_reader_broken;
+     m.ter_set(examx, examy, t_card_reader_broken);
      for (int i = -3; i <= 3; i++) {
       for (int j = -3; j <= 3; j++) {
        if (m.ter(examx + i, examy + j) == t_door_metal_locked)
-        m.ter(examx + i, examy + j) = t_floor;
+        m.ter_set(examx + i, examy + j, t_floor);
       }
      }
     }
@@ -3896,12 +4551,12 @@ void game::examine()
   cur_om = overmap(this, cur_om.posx, cur_om.posy, cur_om.posz + movez);
   m.load(this, levx, levy);
   update_map(u.posx, u.posy);
-  for (int x = 0; x < SEEX * MAPSIZE; x++) {
-   for (int y = 0; y < SEEY * MAPSIZE; y++) {
-    if (m.ter(x, y) == t_elevator) {
-     u.posx = x;
-     u.posy = y;
-    }
+  std::vector<point> elevators = m.find_terrain(t_elevator);
+  for (int i = 0; i < elevators.size(); i++) {
+   if (i == 0 || elevators[i].x > u.posx ||
+       (elevators[i].x == u.posx && elevators[i].y > u.posy)) {
+    u.posx = elevators[i].x;
+    u.posy = elevators[i].y;
    }
   }
   refresh_all();
@@ -3919,7 +4574,7 @@ void game::examine()
   m.add_item(u.posx, u.posy, cot);
   add_msg("You fold up the cot");
   u.moves -=50;
-  m.ter(examx, examy) = t_floor;
+  m.ter_set(examx, examy, t_floor);
  } else if (m.ter(examx, examy) == t_wreckage &&
             query_yn("Sift through the wreckage?")) {
   add_msg("You look for anything useful");
@@ -3932,47 +4587,47 @@ void game::examine()
  } if (one_in(4)) {
     add_msg("You find a chunk of steel!");
     m.add_item(u.posx, u.posy, chunk);
-    m.ter(examx, examy) = t_dirt;
+    m.ter_set(examx, examy, t_dirt);
  } else if (one_in(8)) {
     add_msg("You find a pipe");
     m.add_item(u.posx, u.posy, pipe);
-    m.ter(examx, examy) = t_dirt;
+    m.ter_set(examx, examy, t_dirt);
  } else {
    add_msg("You can find nothing of use");
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
   }
  } else if (m.ter(examx, examy) == t_groundsheet &&
             query_yn("Take down tent?")) {
    add_msg("You take down your tent.");
     item tent(itypes[itm_tent], turn);
-    m.ter(examx, examy) = t_dirt;
-    m.ter(examx +1, examy) = t_dirt;
-    m.ter(examx -1, examy) = t_dirt;
-    m.ter(examx -1, examy +1) = t_dirt;
-    m.ter(examx +1, examy -1) = t_dirt;
-    m.ter(examx -1, examy -1) = t_dirt;
-    m.ter(examx +1, examy +1) = t_dirt;
-    m.ter(examx, examy +1) = t_dirt;
-    m.ter(examx, examy -1) = t_dirt;
+    m.ter_set(examx, examy, t_dirt);
+    m.ter_set(examx +1, examy, t_dirt);
+    m.ter_set(examx -1, examy, t_dirt);
+    m.ter_set(examx -1, examy +1, t_dirt);
+    m.ter_set(examx +1, examy -1, t_dirt);
+    m.ter_set(examx -1, examy -1, t_dirt);
+    m.ter_set(examx +1, examy +1, t_dirt);
+    m.ter_set(examx, examy +1, t_dirt);
+    m.ter_set(examx, examy -1, t_dirt);
     u.moves -= 1000;
     m.add_item(examx, examy, tent);
  } else if (m.ter(examx, examy) == t_awnsheet && query_yn("Take down awning?")) {
    add_msg("You disassemble the awning.");
     item awning(itypes[itm_awning], turn);
-    m.ter(examx, examy) = t_dirt;
-    m.ter(examx +1, examy) = t_dirt;
-    m.ter(examx -1, examy) = t_dirt;
-    m.ter(examx -1, examy +1) = t_dirt;
-    m.ter(examx +1, examy -1) = t_dirt;
-    m.ter(examx -1, examy -1) = t_dirt;
-    m.ter(examx +1, examy +1) = t_dirt;
-    m.ter(examx, examy +1) = t_dirt;
-    m.ter(examx, examy -1) = t_dirt;
+    m.ter_set(examx, examy, t_dirt);
+    m.ter_set(examx +1, examy, t_dirt);
+    m.ter_set(examx -1, examy, t_dirt);
+    m.ter_set(examx -1, examy +1, t_dirt);
+    m.ter_set(examx +1, examy -1, t_dirt);
+    m.ter_set(examx -1, examy -1, t_dirt);
+    m.ter_set(examx +1, examy +1, t_dirt);
+    m.ter_set(examx, examy +1, t_dirt);
+    m.ter_set(examx, examy -1, t_dirt);
     u.moves -= 1000;
     m.add_item(examx, examy, awning);
  } else if (m.ter(examx, examy) == t_pit && query_yn("Place a 2x4 over that pit?")) {
   if (u.has_amount(itm_2x4, 1)) {
-   m.ter(examx, examy) = t_pit_bridge;
+   m.ter_set(examx, examy, t_pit_bridge);
    u.use_amount(itm_2x4, 1);
    u.moves -= 100;
    m.tr_at(examx, examy) = tr_null;
@@ -3981,7 +4636,7 @@ void game::examine()
   }
  } else if (m.ter(examx, examy) == t_pit_spiked && query_yn("Place a 2x4 over that pit?")) {
   if (u.has_amount(itm_2x4, 1)) {
-   m.ter(examx, examy) = t_s_pit_bridge;
+   m.ter_set(examx, examy, t_s_pit_bridge);
    u.use_amount(itm_2x4, 1);
    u.moves -= 100;
    m.tr_at(examx, examy) = tr_null;
@@ -3990,13 +4645,13 @@ void game::examine()
   }
  } else if (m.ter(examx, examy) == t_pit_bridge && query_yn("Remove that 2x4?")) {
   item board(itypes[itm_2x4], turn);
-   m.ter(examx, examy) = t_pit;
+   m.ter_set(examx, examy, t_pit);
    m.add_trap(examx, examy, tr_pit);
    m.add_item(u.posx, u.posy, board);
    u.moves -= 100;
  } else if (m.ter(examx, examy) == t_s_pit_bridge && query_yn("Remove that 2x4?")) {
   item board(itypes[itm_2x4], turn);
-   m.ter(examx, examy) = t_pit_spiked;
+   m.ter_set(examx, examy, t_pit_spiked);
    m.add_trap(examx, examy, tr_spike_pit);
    m.add_item(u.posx, u.posy, board);
    u.moves -= 100;
@@ -4043,20 +4698,20 @@ shape, but with long, twisted, distended limbs.");
  } else if (m.ter(examx, examy) == t_pedestal_wyrm &&
             m.i_at(examx, examy).empty()) {
   add_msg("The pedestal sinks into the ground...");
-  m.ter(examx, examy) = t_rock_floor;
+  m.ter_set(examx, examy, t_rock_floor);
   add_event(EVENT_SPAWN_WYRMS, int(turn) + rng(5, 10));
  } else if (m.ter(examx, examy) == t_pedestal_temple) {
   if (m.i_at(examx, examy).size() == 1 &&
       m.i_at(examx, examy)[0].type->id == itm_petrified_eye) {
    add_msg("The pedestal sinks into the ground...");
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    m.i_at(examx, examy).clear();
    add_event(EVENT_TEMPLE_OPEN, int(turn) + 4);
   } else if (u.has_amount(itm_petrified_eye, 1) &&
              query_yn("Place your petrified eye on the pedestal?")) {
    u.use_amount(itm_petrified_eye, 1);
    add_msg("The pedestal sinks into the ground...");
-   m.ter(examx, examy) = t_dirt;
+   m.ter_set(examx, examy, t_dirt);
    add_event(EVENT_TEMPLE_OPEN, int(turn) + 4);
   } else
    add_msg("This pedestal is engraved in eye-shaped diagrams, and has a large\
@@ -4065,55 +4720,38 @@ shape, but with long, twisted, distended limbs.");
             m.ter(examx, examy) <= t_switch_even &&
             query_yn("Flip the %s?", m.tername(examx, examy).c_str())) {
   u.moves -= 100;
-  for (int y = examy; y <= examy + 5; y++) {
-   for (int x = 0; x < SEEX * MAPSIZE; x++) {
-    switch (m.ter(examx, examy)) {
-     case t_switch_rg:
-      if (m.ter(x, y) == t_rock_red)
-       m.ter(x, y) = t_floor_red;
-      else if (m.ter(x, y) == t_floor_red)
-       m.ter(x, y) = t_rock_red;
-      else if (m.ter(x, y) == t_rock_green)
-       m.ter(x, y) = t_floor_green;
-      else if (m.ter(x, y) == t_floor_green)
-       m.ter(x, y) = t_rock_green;
-      break;
-     case t_switch_gb:
-      if (m.ter(x, y) == t_rock_blue)
-       m.ter(x, y) = t_floor_blue;
-      else if (m.ter(x, y) == t_floor_blue)
-       m.ter(x, y) = t_rock_blue;
-      else if (m.ter(x, y) == t_rock_green)
-       m.ter(x, y) = t_floor_green;
-      else if (m.ter(x, y) == t_floor_green)
-       m.ter(x, y) = t_rock_green;
-      break;
-     case t_switch_rb:
-      if (m.ter(x, y) == t_rock_blue)
-       m.ter(x, y) = t_floor_blue;
-      else if (m.ter(x, y) == t_floor_blue)
-       m.ter(x, y) = t_rock_blue;
-      else if (m.ter(x, y) == t_rock_red)
-       m.ter(x, y) = t_floor_red;
-      else if (m.ter(x, y) == t_floor_red)
-       m.ter(x, y) = t_rock_red;
-      break;
-     case t_switch_even:
-      if ((y - examy) % 2 == 1) {
-       if (m.ter(x, y) == t_rock_red)
-        m.ter(x, y) = t_floor_red;
-       else if (m.ter(x, y) == t_floor_red)
-        m.ter(x, y) = t_rock_red;
-       else if (m.ter(x, y) == t_rock_green)
-        m.ter(x, y) = t_floor_green;
-       else if (m.ter(x, y) == t_floor_green)
-        m.ter(x, y) = t_rock_green;
-       else if (m.ter(x, y) == t_rock_blue)
-        m.ter(x, y) = t_floor_blue;
-       else if (m.ter(x, y) == t_floor_blue)
-        m.ter(x, y) = t_rock_blue;
-      }
-      break;
+// Each switch swaps the rock and floor of its colours in the next six rows
+  std::vector<ter_id> rocks;
+  switch (m.ter(examx, examy)) {
+   case t_switch_rg:
+    rocks.push_back(t_rock_red);
+    rocks.push_back(t_rock_green);
+    break;
+   case t_switch_gb:
+    rocks.push_back(t_rock_blue);
+    rocks.push_back(t_rock_green);
+    break;
+   case t_switch_rb:
+    rocks.push_back(t_rock_blue);
+    rocks.push_back(t_rock_red);
+    break;
+   case t_switch_even:
+    rocks.push_back(t_rock_red);
+    rocks.push_back(t_rock_green);
+    rocks.push_back(t_rock_blue);
+    break;
+  }
+  bool odd_rows = (m.ter(examx, examy) == t_switch_even);
+  for (int c = 0; c < rocks.size(); c++) {
+   ter_id rock = rocks[c], floor = ter_id(int(rock) + 3); // t_floor_red etc.
+   std::vector<point> found[2];
+   found[0] = m.find_terrain(rock);
+   found[1] = m.find_terrain(floor);
+   for (int f = 0; f < 2; f++) {
+    for (int i = 0; i < found[f].size(); i++) {
+     int x = found[f][i].x, y = found[f][i].y;
+     if (y >= examy && y <= examy + 5 && (!odd_rows || (y - examy) % 2 == 1))
+      m.ter_set(x, y, (f == 0 ? floor : rock));
     }
    }
   }
@@ -5230,7 +5868,7 @@ void game::eat()
      query_yn("Eat underbrush?")) {
   u.moves -= 400;
   u.hunger -= 10;
-  m.ter(u.posx, u.posy) = t_grass;
+  m.ter_set(u.posx, u.posy, t_grass);
   add_msg("You eat the underbrush.");
   return;
  }
@@ -5622,17 +6260,14 @@ void game::plmove(int x, int y)
 // Otherwise, actual movement, zomg
  if (u.has_disease(DI_AMIGARA)) {
   int curdist = 999, newdist = 999;
-  for (int cx = 0; cx < SEEX * MAPSIZE; cx++) {
-   for (int cy = 0; cy < SEEY * MAPSIZE; cy++) {
-    if (m.ter(cx, cy) == t_fault) {
-     int dist = rl_dist(cx, cy, u.posx, u.posy);
-     if (dist < curdist)
-      curdist = dist;
-     dist = rl_dist(cx, cy, x, y);
-     if (dist < newdist)
-      newdist = dist;
-    }
-   }
+  std::vector<point> faults = m.find_terrain(t_fault);
+  for (int i = 0; i < faults.size(); i++) {
+   int dist = rl_dist(faults[i].x, faults[i].y, u.posx, u.posy);
+   if (dist < curdist)
+    curdist = dist;
+   dist = rl_dist(faults[i].x, faults[i].y, x, y);
+   if (dist < newdist)
+    newdist = dist;
   }
   if (newdist > curdist) {
    add_msg("You cannot pull yourself away from the faultline...");
@@ -6010,16 +6645,25 @@ void game::vertical_move(int movez, bool force)
   stairy = u.posy;
  } else { // We need to find the stairs.
   int best = 999;
-   for (int i = u.posx - SEEX * 2; i <= u.posx + SEEX * 2; i++) {
-    for (int j = u.posy - SEEY * 2; j <= u.posy + SEEY * 2; j++) {
-    if (rl_dist(u.posx, u.posy, i, j) <= best &&
-        ((movez == -1 && tmpmap.has_flag(goes_up, i, j)) ||
-         (movez ==  1 && (tmpmap.has_flag(goes_down, i, j) ||
-                          tmpmap.ter(i, j) == t_manhole_cover)))) {
-     stairx = i;
-     stairy = j;
-     best = rl_dist(u.posx, u.posy, i, j);
-    }
+  std::vector<point> stairs;
+  if (movez == -1)
+   stairs = tmpmap.find_terrain(goes_up);
+  else {
+   stairs = tmpmap.find_terrain(goes_down);
+   std::vector<point> covers = tmpmap.find_terrain(t_manhole_cover);
+   stairs.insert(stairs.end(), covers.begin(), covers.end());
+  }
+// Closest within two submaps; ties go to the greatest x, then y
+  for (int i = 0; i < stairs.size(); i++) {
+   int sx = stairs[i].x, sy = stairs[i].y;
+   if (abs(sx - u.posx) > SEEX * 2 || abs(sy - u.posy) > SEEY * 2)
+    continue;
+   int dist = rl_dist(u.posx, u.posy, sx, sy);
+   if (dist < best || (dist == best &&
+                       (sx > stairx || (sx == stairx && sy > stairy)))) {
+    stairx = sx;
+    stairy = sy;
+    best = dist;
    }
   }
 
@@ -6080,6 +6724,7 @@ void game::vertical_move(int movez, bool force)
   }
  }
  z.clear();
+ sounds.clear();
 
 // Figure out where we know there are up/down connectors
  std::vector<point> discover;
@@ -6113,11 +6758,11 @@ void game::vertical_move(int movez, bool force)
  u.posx = stairx;
  u.posy = stairy;
  if (rope_ladder)
-  m.ter(u.posx, u.posy) = t_rope_up;
+  m.ter_set(u.posx, u.posy, t_rope_up);
  if (m.ter(stairx, stairy) == t_manhole_cover) {
   m.add_item(stairx + rng(-1, 1), stairy + rng(-1, 1),
              itypes[itm_manhole_cover], 0);
-  m.ter(stairx, stairy) = t_manhole;
+  m.ter_set(stairx, stairy, t_manhole);
  }
 
  if (replace_monsters)
@@ -6211,7 +6856,7 @@ void game::update_map(int &x, int &y)
     if (group != -1) {
      cur_om.zg[group].population++;
      if (cur_om.zg[group].population / pow(cur_om.zg[group].radius, 2.0) > 5)
-      cur_om.zg[group].radius++;
+      cur_om.grow_mongroup(group);
     }
 /*  Removing adding new groups for now.  Haha!
  else if (mt_to_mc((mon_id)(z[i].type->id)) != mcat_null)
@@ -6223,6 +6868,16 @@ void game::update_map(int &x, int &y)
    i--;
   }
  }
+// Shift sounds not yet heard, dropping any that left the map
+ for (int i = 0; i < sounds.size(); i++) {
+  sounds[i].x -= shiftx * SEEX;
+  sounds[i].y -= shifty * SEEY;
+  if (sounds[i].x < 0 || sounds[i].x >= SEEX * MAPSIZE ||
+      sounds[i].y < 0 || sounds[i].y >= SEEY * MAPSIZE) {
+   sounds.erase(sounds.begin() + i);
+   i--;
+  }
+ }
 // Shift NPCs
  for (int i = 0; i < active_npc.size(); i++) {
   active_npc[i].shift(shiftx, shifty);
@@ -6277,14 +6932,13 @@ void game::update_map(int &x, int &y)
  if (turn >= nextspawn)
   spawn_mon(shiftx, shifty);
 // Shift scent
- unsigned int newscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
  for (int i = 0; i < SEEX * MAPSIZE; i++) {
   for (int j = 0; j < SEEY * MAPSIZE; j++)
-   newscent[i][j] = scent(i + (shiftx * SEEX), j + (shifty * SEEY));
+   scent_buf[i][j] = scent(i + (shiftx * SEEX), j + (shifty * SEEY));
  }
  for (int i = 0; i < SEEX * MAPSIZE; i++) {
   for (int j = 0; j < SEEY * MAPSIZE; j++)
-   scent(i, j) = newscent[i][j];
+   scent(i, j) = scent_buf[i][j];
  }
 // Update what parts of the world map we can see
  update_overmap_seen();
@@ -6416,35 +7070,34 @@ void game::update_stair_monsters()
  if (abs(levx - monstairx) > 1 || abs(levy - monstairy) > 1)
   return;
 
+ std::vector<point> stairs = m.find_terrain(goes_up);
+ std::vector<point> stairs_down = m.find_terrain(goes_down);
+ for (int i = 0; i < stairs_down.size(); i++) {
+  if (!m.has_flag(goes_up, stairs_down[i].x, stairs_down[i].y))
+   stairs.push_back(stairs_down[i]);	// Don't count two-way stairs twice
+ }
  for (int i = 0; i < coming_to_stairs.size(); i++) {
   coming_to_stairs[i].count--;
   if (coming_to_stairs[i].count <= 0) {
-   int startx = rng(0, SEEX * MAPSIZE - 1), starty = rng(0, SEEY * MAPSIZE - 1);
-   bool found_stairs = false;
-   for (int x = 0; x < SEEX * MAPSIZE && !found_stairs; x++) {
-    for (int y = 0; y < SEEY * MAPSIZE && !found_stairs; y++) {
-     int sx = (startx + x) % (SEEX * MAPSIZE),
-         sy = (starty + y) % (SEEY * MAPSIZE);
-     if (m.has_flag(goes_up, sx, sy) || m.has_flag(goes_down, sx, sy)) {
-      found_stairs = true;
-      int mposx = sx, mposy = sy;
-      int tries = 0;
-      while (!is_empty(mposx, mposy) && tries < 10) {
-       mposx = sx + rng(-2, 2);
-       mposy = sy + rng(-2, 2);
-       tries++;
-      }
-      if (tries < 10) {
-       coming_to_stairs[i].mon.posx = sx;
-       coming_to_stairs[i].mon.posy = sy;
-       z.push_back( coming_to_stairs[i].mon );
-       int t;
-       if (u_see(sx, sy, t))
-        add_msg("A %s comes %s the %s!", coming_to_stairs[i].mon.name().c_str(),
-                (m.has_flag(goes_up, sx, sy) ? "down" : "up"),
-                m.tername(sx, sy).c_str());
-      }
-     }
+   if (!stairs.empty()) {
+    point stair = stairs[rng(0, stairs.size() - 1)];
+    int sx = stair.x, sy = stair.y;
+    int mposx = sx, mposy = sy;
+    int tries = 0;
+    while (!is_empty(mposx, mposy) && tries < 10) {
+     mposx = sx + rng(-2, 2);
+     mposy = sy + rng(-2, 2);
+     tries++;
+    }
+    if (tries < 10) {
+     coming_to_stairs[i].mon.posx = sx;
+     coming_to_stairs[i].mon.posy = sy;
+     z.push_back( coming_to_stairs[i].mon );
+     int t;
+     if (u_see(sx, sy, t))
+      add_msg("A %s comes %s the %s!", coming_to_stairs[i].mon.name().c_str(),
+              (m.has_flag(goes_up, sx, sy) ? "down" : "up"),
+              m.tername(sx, sy).c_str());
     }
    }
    coming_to_stairs.erase(coming_to_stairs.begin() + i);
@@ -6484,7 +7137,10 @@ void game::spawn_mon(int shiftx, int shifty)
 
 // Now, spawn monsters (perhaps)
  monster zom;
- for (int i = 0; i < cur_om.zg.size(); i++) { // For each valid group...
+ std::vector<int> nearby = cur_om.mongroups_near(nlevx, nlevy);
+ std::vector<int> emptied;
+ for (int n = 0; n < nearby.size(); n++) { // For each valid group...
+  int i = nearby[n];
   group = 0;
   dist = trig_dist(nlevx, nlevy, cur_om.zg[i].posx, cur_om.zg[i].posy);
   pop = cur_om.zg[i].population;
@@ -6535,12 +7191,15 @@ void game::spawn_mon(int shiftx, int shifty)
      }
     }
    }	// Placing monsters of this group is done!
-   if (cur_om.zg[i].population <= 0) { // Last monster in the group spawned...
-    cur_om.zg.erase(cur_om.zg.begin() + i); // ...so remove that group
-    i--;	// And don't increment i.
-   }
+   if (cur_om.zg[i].population <= 0) // Last monster in the group spawned...
+    emptied.push_back(i);
   }
  }
+// ...so remove those groups, from the back so the indices stay good
+ for (int i = emptied.size() - 1; i >= 0; i--)
+  cur_om.zg.erase(cur_om.zg.begin() + emptied[i]);
+ if (!emptied.empty())
+  cur_om.index_mongroups();
 }
 
 mon_id game::valid_monster_from(std::vector<mon_id> group)
@@ -6573,7 +7232,9 @@ int game::valid_group(mon_id type, int x, int y)
  std::vector <int> valid_groups;
  std::vector <int> semi_valid;	// Groups that're ALMOST big enough
  int dist;
- for (int i = 0; i < cur_om.zg.size(); i++) {
+ std::vector<int> nearby = cur_om.mongroups_near(x, y, 3);
+ for (int n = 0; n < nearby.size(); n++) {
+  int i = nearby[n];
   dist = trig_dist(x, y, cur_om.zg[i].posx, cur_om.zg[i].posy);
   if (dist < cur_om.zg[i].radius) {
    for (int j = 0; j < (moncats[cur_om.zg[i].type]).size(); j++) {
@@ -6598,7 +7259,7 @@ int game::valid_group(mon_id type, int x, int y)
 // If there's a group that's ALMOST big enough, expand that group's radius
 // by one and absorb into that group.
    int semi = rng(0, semi_valid.size() - 1);
-   cur_om.zg[semi_valid[semi]].radius++;
+   cur_om.grow_mongroup(semi_valid[semi]);
    return semi_valid[semi];
   }
  }
@@ -6710,17 +7371,16 @@ void game::nuke(int x, int y)
  int mapx = x * 2, mapy = y * 2;
  map tmpmap(&itypes, &mapitems, &traps);
  tmpmap.load(this, mapx, mapy);
- for (int i = 0; i < SEEX * 2; i++) {
-  for (int j = 0; j < SEEY * 2; j++) {
-   if (!one_in(10))
-    tmpmap.ter(i, j) = t_rubble;
-   if (one_in(3))
-    tmpmap.add_field(NULL, i, j, fd_nuke_gas, 3);
-   tmpmap.radiation(i, j) += rng(20, 80);
-  }
+ for (map_iterator it = tmpmap.rect(0, 0, SEEX * 2 - 1, SEEY * 2 - 1);
+      !it.done(); it.next()) {
+  if (!one_in(10))
+   tmpmap.ter_set(it.x, it.y, t_rubble);
+  if (one_in(3))
+   tmpmap.add_field(NULL, it.x, it.y, fd_nuke_gas, 3);
+  it.radiation() += rng(20, 80);
  }
  tmpmap.save(&cur_om, turn, mapx, mapy);
- cur_om.ter(x, y) = ot_crater;
+ cur_om.oter_set(x, y, ot_crater);
  cur_om = tmp_om;
 }
 
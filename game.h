@@ -24,6 +24,29 @@
 #include <vector>
 
 #define LONG_RANGE 10
+// Monsters pursue the player along a shared distance field out to this range;
+// 0 disables the field and monsters only use their straight-line plans
+#define PURSUIT_RANGE 60
+// Monsters further than this from the player and any NPC, out of sight, and
+// with no sound, scent or plans to follow, only act every MON_DORMANT_TURNS
+#define MON_AWAKE_RANGE 12
+#define MON_DORMANT_TURNS 5
+// Overmap routes search this many tiles beyond the box spanning both ends, and
+// at most this many are remembered before the cache is flushed
+#define OM_ROUTE_PAD 20
+#define OM_ROUTE_CACHE 64
+// Scent spreads within this many squares of the player each turn; SEEX * MAPSIZE
+// covers the whole reality bubble
+#define SCENT_RADIUS 18
+// While sleeping, waiting, crafting or reading with no monsters or NPCs within
+// FF_RANGE and no fields nearby, scent, fields and monsters only get a turn
+// every FF_STRIDE turns
+#define FF_RANGE 24
+#define FF_STRIDE 10
+// Sound loses 1 volume per open square it crosses, SOUND_WINDOW per window and
+// SOUND_WALL per wall or closed door
+#define SOUND_WINDOW 2
+#define SOUND_WALL 5
 #define BLINK_SPEED 300
 #define BULLET_SPEED 10000000
 #define EXPLOSION_SPEED 70000000
@@ -49,6 +72,29 @@ struct monster_and_count
  monster_and_count(monster M, int C) : mon (M), count (C) {};
 };
 
+struct sound_event
+{
+ int x, y, vol;
+ sound_event(int X, int Y, int V) : x (X), y (Y), vol (V) {};
+};
+
+// Who holds an item, as game::find_item() last found it
+enum item_owner_type {
+ IO_PLAYER,	// Wielded, worn or carried by the player
+ IO_NPC,	// Likewise, by the NPC whose id is npc_id
+ IO_MAP,	// Lying on the ground at pos
+ IO_VEHICLE	// In the cargo of vehicle part "part", which lies at pos
+};
+
+struct item_owner
+{
+ item_owner_type type;
+ int npc_id, part;
+ point pos;
+ item_owner(item_owner_type T = IO_MAP, int N = -1, point P = point(-1, -1),
+            int V = -1) : type (T), npc_id (N), part (V), pos (P) {};
+};
+
 struct mtype;
 struct mission_type;
 class map;
@@ -90,6 +136,9 @@ class game
   void emp_blast(int x, int y);
   int  npc_at(int x, int y);	// Index of the npc at (x, y); -1 for none
   int  mon_at(int x, int y);	// Index of the monster at (x, y); -1 for none
+// Indices of the npcs/monsters from (x1, y1) to (x2, y2) inclusive, ascending
+  std::vector<int> npcs_in_rect(int x1, int y1, int x2, int y2);
+  std::vector<int> mons_in_rect(int x1, int y1, int x2, int y2);
   bool is_empty(int x, int y);	// True if no PC, no monster, move cost > 0
   bool isBetween(int test, int down, int up);
   bool is_in_sunlight(int x, int y); // Checks outdoors + sunny
@@ -133,13 +182,22 @@ class game
   void nuke(int x, int y);
   std::vector<faction *> factions_at(int x, int y);
   int& scent(int x, int y);
+  int pursuit_dist(int x, int y); // Move cost to reach the player, 999 if none
+// Cheapest chain of overmap tiles from one cur_om coordinate to another, not
+//  including from; may cross into the loaded adjacent overmaps.  Empty if the
+//  goal can't be reached.
+  std::vector<point> om_route(point from, point to);
   unsigned char light_level();
   int assign_npc_id();
   int assign_faction_id();
   faction* faction_by_id(int it);
   bool sees_u(int x, int y, int &t);
+// u_see answers from the map's cached field of view and leaves t untouched;
+//  use m.sees() when a line to the target is needed
   bool u_see (int x, int y, int &t);
   bool u_see (monster *mon, int &t);
+// Like u_see, answers from a field of view cast from p's position (shared by
+//  every monster p checks this turn) and leaves t untouched
   bool pl_sees(player *p, monster *mon, int &t);
   void refresh_all();
   void update_map(int &x, int &y);  // Called by plmove when the map updates
@@ -281,7 +339,15 @@ class game
   moncat_id mt_to_mc(mon_id type);// Monster type to monster category
   void set_adjacent_overmaps(bool from_scratch = false);
 
+// Item locating; see find_item()
+  bool locate_item(item *it, item_owner &owner);
+  bool owner_has(item *it, item_owner &owner);
+
 // Routine loop functions, approximately in order of execution
+  void schedule_tasks();   // Files the periodic work in tasks afresh
+  void schedule_spawn_check(); // After nextspawn comes any sooner
+  bool fast_forward();     // Can the world away from the player be skipped?
+  void process_sounds();   // Lets monsters hear this turn's sounds
   void monmove();          // Monster movement
   void om_npcs_move();     // Movement of NPCs on the overmap (non-local)
   void check_warmth();     // Checks the player's warmth (applying clothing)
@@ -293,6 +359,9 @@ class game
   void mon_info();         // Prints a list of nearby monsters (top right)
   void get_input();        // Gets player input and calls the proper function
   void update_scent();     // Updates the scent map
+  void update_pursuit();   // Rebuilds the pursuit map when it's out of date
+  int om_travel_cost(int x, int y); // Cost to enter an overmap tile, 0 if none
+  std::vector<int> om_route_stamp(); // Which overmaps om_routes were built on
   bool is_game_over();     // Returns true if the player quit or died
   void death_screen();     // Display our stats, "GAME OVER BOO HOO"
   void gameover();         // Ends the game
@@ -337,7 +406,22 @@ class game
   unsigned char curmes;	  // The last-seen message.  Older than 256 is deleted.
   int grscent[SEEX * MAPSIZE][SEEY * MAPSIZE];	// The scent map
   int nulscent;				// Returned for OOB scent checks
-  std::vector<event> events;	        // Game events to be processed
+  int scent_buf[SEEX * MAPSIZE][SEEY * MAPSIZE];	// update_scent() writes here
+// -1 where scent can't spread, else the least scent there (slime leaves some)
+  int scent_floor[SEEX * MAPSIZE][SEEY * MAPSIZE];
+  int pursuit[SEEX * MAPSIZE][SEEY * MAPSIZE]; // Move cost to reach the player
+  std::vector<sound_event> sounds;	// Made this turn, for process_sounds()
+  int sound_dist[SEEX * MAPSIZE][SEEY * MAPSIZE]; // Volume lost getting here
+  int sound_mon[SEEX * MAPSIZE][SEEY * MAPSIZE];  // Listener here, or -1
+  int pursuit_turn, pursuit_x, pursuit_y; // When & where it was built
+  int pursuit_gen;	// m.tile_gen when it was built
+  int ff_skipped;	// Turns fast_forward() has skipped the world for
+  std::map<std::pair<int, int>, std::vector<point> > om_routes; // By from, to
+  std::vector<int> om_routes_stamp;	// om_route_stamp() when om_routes began
+  std::map<item*, item_owner> item_owners; // Hints for find_item(); checked
+  event_wheel events;	        // Game events to be processed
+  event_wheel tasks;	// Periodic work; rebuilt by schedule_tasks(), not saved
+  int spawn_check_turn;	// When the live TASK_SPAWN in tasks is due
   int kills[num_monsters];	        // Player's kill count
   std::string last_action;		// The keypresses of last turn
 
@@ -208,42 +208,42 @@ void inventory::restack(game *g)
 void inventory::form_from_map(game *g, point origin, int range)
 {
  items.clear();
- for (int x = origin.x - range; x <= origin.x + range; x++) {
-  for (int y = origin.y - range; y <= origin.y + range; y++) {
-   for (int i = 0; i < g->m.i_at(x, y).size(); i++)
-    if (!g->m.i_at(x, y)[i].made_of(LIQUID))
-     add_item(g->m.i_at(x, y)[i]);
+ for (map_iterator it = g->m.radius(origin.x, origin.y, range); !it.done();
+      it.next()) {
+  std::vector<item> &here = it.items();
+  for (int i = 0; i < here.size(); i++)
+   if (!here[i].made_of(LIQUID))
+    add_item(here[i]);
 // Kludge for now!
-   if (g->m.field_at(x, y).type == fd_fire) {
-    item fire(g->itypes[itm_fire], 0);
-    fire.charges = 1;
-    add_item(fire);
-   }
-   if (g->m.ter(x, y) == t_forge) {
-    item forge(g->itypes[itm_forge], 0);
-    forge.charges = 1;
-    add_item(forge);
-   }
-   if (g->m.ter(x, y) == t_grindstone) {
-    item grind(g->itypes[itm_grindstone], 0);
-    grind.charges = 1;
-    add_item(grind);
-   }
-   if (g->m.ter(x, y) == t_watertub) {
-    item water(g->itypes[itm_forgewater], 0);
-    water.charges = 1;
-    add_item(water);
-   }
-   if (g->m.ter(x, y) == t_crucible) {
-    item crucible(g->itypes[itm_hot_crucible], 0);
-    crucible.charges = 1;
-    add_item(crucible);
-   }
-   if (g->m.ter(x, y) == t_anvil) {
-    item anvil(g->itypes[itm_anvil], 0);
-    anvil.charges = 1;
-    add_item(anvil);
-   }
+  if (it.fld().type == fd_fire) {
+   item fire(g->itypes[itm_fire], 0);
+   fire.charges = 1;
+   add_item(fire);
+  }
+  if (it.ter() == t_forge) {
+   item forge(g->itypes[itm_forge], 0);
+   forge.charges = 1;
+   add_item(forge);
+  }
+  if (it.ter() == t_grindstone) {
+   item grind(g->itypes[itm_grindstone], 0);
+   grind.charges = 1;
+   add_item(grind);
+  }
+  if (it.ter() == t_watertub) {
+   item water(g->itypes[itm_forgewater], 0);
+   water.charges = 1;
+   add_item(water);
+  }
+  if (it.ter() == t_crucible) {
+   item crucible(g->itypes[itm_hot_crucible], 0);
+   crucible.charges = 1;
+   add_item(crucible);
+  }
+  if (it.ter() == t_anvil) {
+   item anvil(g->itypes[itm_anvil], 0);
+   anvil.charges = 1;
+   add_item(anvil);
   }
  }
 }
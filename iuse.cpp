@@ -836,6 +836,7 @@ void iuse::extinguisher(game *g, player *p, item *it, bool t)
    g->m.field_at(x, y).density = 1;
    g->m.remove_field(x, y);
   }
+  g->m.touch_tile(x, y);
  }
  int mondex = g->mon_at(x, y);
  if (mondex != -1) {
@@ -861,6 +862,7 @@ void iuse::extinguisher(game *g, player *p, item *it, bool t)
     g->m.field_at(x, y).density = 1;
     g->m.remove_field(x, y);
    }
+   g->m.touch_tile(x, y);
   }
  }
 }
@@ -902,7 +904,7 @@ void iuse::hammer(game *g, player *p, item *it, bool t)
  item board(g->itypes[itm_2x4], 0, g->nextinv);
  for (int i = 0; i < boards; i++)
   g->m.add_item(p->posx, p->posy, board);
- g->m.ter(dirx, diry) = newter;
+ g->m.ter_set(dirx, diry, newter);
 }
  
 void iuse::light_off(game *g, player *p, item *it, bool t)
@@ -1098,7 +1100,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (dice(4, 6) < dice(4, p->str_cur)) {
    g->add_msg("You pry the door open.");
    p->moves -= (150 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_door_o;
+   g->m.ter_set(dirx, diry, t_door_o);
   } else {
    g->add_msg("You pry, but cannot open the door.");
    p->moves -= 100;
@@ -1107,7 +1109,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (dice(8, 8) < dice(8, p->str_cur)) {
    g->add_msg("You lift the manhole cover.");
    p->moves -= (500 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_manhole;
+   g->m.ter_set(dirx, diry, t_manhole);
    g->m.add_item(p->posx, p->posy, g->itypes[itm_manhole_cover], 0);
   } else {
    g->add_msg("You pry, but cannot lift the manhole cover.");
@@ -1117,7 +1119,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   if (p->str_cur >= rng(3, 30)) {
    g->add_msg("You pop the crate open.");
    p->moves -= (150 - (p->str_cur * 5));
-   g->m.ter(dirx, diry) = t_crate_o;
+   g->m.ter_set(dirx, diry, t_crate_o);
   } else {
    g->add_msg("You pry, but cannot open the crate.");
    p->moves -= 100;
@@ -1147,7 +1149,7 @@ void iuse::crowbar(game *g, player *p, item *it, bool t)
   item board(g->itypes[itm_2x4], 0, g->nextinv);
   for (int i = 0; i < boards; i++)
    g->m.add_item(p->posx, p->posy, board);
-  g->m.ter(dirx, diry) = newter;
+  g->m.ter_set(dirx, diry, newter);
  }
 }
 
@@ -1156,7 +1158,7 @@ void iuse::makemound(game *g, player *p, item *it, bool t)
  if (g->m.has_flag(diggable, p->posx, p->posy)) {
   g->add_msg("You churn up the earth here.");
   p->moves = -300;
-  g->m.ter(p->posx, p->posy) = t_dirtmound;
+  g->m.ter_set(p->posx, p->posy, t_dirtmound);
  } else
   g->add_msg("You can't churn up this ground.");
 }
@@ -1178,7 +1180,7 @@ void iuse::dig(game *g, player *p, item *it, bool t)
   if (!one_in(6)) {
     g->add_msg("You find no clay");
     p->moves -= 200;
-    g->m.ter(dirx, diry) = t_dirt;
+    g->m.ter_set(dirx, diry, t_dirt);
  } else {
     p->moves -= 200;
     g->add_msg("You find some clay!");
@@ -2089,7 +2091,7 @@ void iuse::axe(game *g, player *p, item *it, bool t)
   g->add_msg("You chop down the tree.");
   g->sound(p->posx, p->posy, 50, "CRASH");
    p->moves -= (10000 - (p->str_cur * 20));
-   g->m.ter(dirx, diry) = t_stump;
+   g->m.ter_set(dirx, diry, t_stump);
     int logs = rng(2, 6);
     item log(g->itypes[itm_log], 0, g->nextinv);
     for (int i = 0; i < logs; i++)
@@ -2099,7 +2101,7 @@ void iuse::axe(game *g, player *p, item *it, bool t)
   g->add_msg("A single swing and the sapling falls to the ground.");
   g->sound(p->posx, p->posy, 5, "CHNK");
   p->moves -= (100);
-  g->m.ter(dirx, diry) = t_dirt;
+  g->m.ter_set(dirx, diry, t_dirt);
    int sticks = rng(1, 3);
    item stick(g->itypes[itm_stick], 0, g->nextinv);
    for (int i = 0; i < sticks; i++)
@@ -2109,7 +2111,7 @@ void iuse::axe(game *g, player *p, item *it, bool t)
   g->add_msg("You hack the stump into splinters");
   g->sound(p->posx, p->posy, 5, "THUNK, THUNK, THUNK");
   p->moves -= (2000);
-  g->m.ter(dirx, diry) = t_dirt;
+  g->m.ter_set(dirx, diry, t_dirt);
    int splinters = rng(1, 3);
    item splinter(g->itypes[itm_splinter], 0, g->nextinv);
    for (int i = 0; i < splinters; i++)
@@ -2140,15 +2142,15 @@ void iuse::tent(game *g, player *p, item *it, bool t)
      g->m.has_flag(diggable, dirx, diry +1)) {
   g->add_msg("You stake your tent into the ground");
    p->moves -= (5000 - (p->sklevel[sk_survival] * 200));
-   g->m.ter(dirx, diry) = t_flap_c;
-   g->m.ter(dirx +1, diry) = t_tent;
-   g->m.ter(dirx -1, diry) = t_tent;
-   g->m.ter(dirx +1, diry +1) = t_flap_c;
-   g->m.ter(dirx +1, diry +2) = t_tent;
-   g->m.ter(dirx, diry +2) = t_flap_c;
-   g->m.ter(dirx -1, diry +2) = t_tent;
-   g->m.ter(dirx -1, diry +1) = t_flap_c;
-   g->m.ter(dirx, diry +1) = t_groundsheet;
+   g->m.ter_set(dirx, diry, t_flap_c);
+   g->m.ter_set(dirx +1, diry, t_tent);
+   g->m.ter_set(dirx -1, diry, t_tent);
+   g->m.ter_set(dirx +1, diry +1, t_flap_c);
+   g->m.ter_set(dirx +1, diry +2, t_tent);
+   g->m.ter_set(dirx, diry +2, t_flap_c);
+   g->m.ter_set(dirx -1, diry +2, t_tent);
+   g->m.ter_set(dirx -1, diry +1, t_flap_c);
+   g->m.ter_set(dirx, diry +1, t_groundsheet);
    it->invlet = 0;
  }
 }
@@ -2176,15 +2178,15 @@ void iuse::awning(game *g, player *p, item *it, bool t)
      g->m.has_flag(diggable, dirx, diry +1)) {
   g->add_msg("You set up the awning");
    p->moves -= (5000 - (p->sklevel[sk_survival] * 200));
-   g->m.ter(dirx, diry) = t_awnfloor;
-   g->m.ter(dirx +1, diry) = t_support;
-   g->m.ter(dirx -1, diry) = t_support;
-   g->m.ter(dirx +1, diry +1) = t_awnfloor;
-   g->m.ter(dirx +1, diry +2) = t_support;
-   g->m.ter(dirx, diry +2) = t_awnfloor;
-   g->m.ter(dirx -1, diry +2) = t_support;
-   g->m.ter(dirx -1, diry +1) = t_awnfloor;
-   g->m.ter(dirx, diry +1) = t_awnsheet;
+   g->m.ter_set(dirx, diry, t_awnfloor);
+   g->m.ter_set(dirx +1, diry, t_support);
+   g->m.ter_set(dirx -1, diry, t_support);
+   g->m.ter_set(dirx +1, diry +1, t_awnfloor);
+   g->m.ter_set(dirx +1, diry +2, t_support);
+   g->m.ter_set(dirx, diry +2, t_awnfloor);
+   g->m.ter_set(dirx -1, diry +2, t_support);
+   g->m.ter_set(dirx -1, diry +1, t_awnfloor);
+   g->m.ter_set(dirx, diry +1, t_awnsheet);
    it->invlet = 0;
  }
 }
@@ -2267,7 +2269,7 @@ void iuse::pickaxe(game *g, player *p, item *it, bool t)
   g->add_msg("You mine into the wall.");
   g->sound(p->posx, p->posy, 15, "CHINK! CHINK! CHINK!");
    p->moves -= (10000 - (p->str_cur * 20));
-   g->m.ter(dirx, diry) = t_rock_floor;
+   g->m.ter_set(dirx, diry, t_rock_floor);
     int rocks = rng(1, 15);
     item rock(g->itypes[itm_rock], 0, g->nextinv);
     for (int i = 0; i < rocks; i++)
@@ -2277,7 +2279,7 @@ void iuse::pickaxe(game *g, player *p, item *it, bool t)
   g->add_msg("You smash up the road into stones");
   g->sound(p->posx, p->posy, 5, "CHINK! CHINK!");
   p->moves -= (5000);
-  g->m.ter(dirx, diry) = t_dirt;
+  g->m.ter_set(dirx, diry, t_dirt);
    int rocks = rng(2, 6);
    item rock(g->itypes[itm_rock], 0, g->nextinv);
    for (int i = 0; i < rocks; i++)
@@ -2307,7 +2309,7 @@ void iuse::barricade(game *g, player *p, item *it, bool t)
  if (type == t_dirt|| type == t_grass) {
   g->add_msg("You stake your barricade in");
    p->moves -= (1000);
-   g->m.ter(dirx, diry) = t_spikebar;
+   g->m.ter_set(dirx, diry, t_spikebar);
    it->invlet = 0;
  } else {
   g->add_msg("You can only place this in dirt or grass");
@@ -2331,7 +2333,7 @@ void iuse::efence(game *g, player *p, item *it, bool t)
  if (type == t_dirt|| type == t_grass) {
   g->add_msg("You stake your fence in and wire it up");
    p->moves -= (1000);
-   g->m.ter(dirx, diry) = t_fence_electric;
+   g->m.ter_set(dirx, diry, t_fence_electric);
    it->invlet = 0;
  } else {
   g->add_msg("You can only place this in dirt or grass");
@@ -2354,7 +2356,7 @@ void iuse::cot(game *g, player *p, item *it, bool t)
  if (type == t_floor) {
   g->add_msg("You unfold your cot and lay in on the ground");
    p->moves -= (10);
-   g->m.ter(dirx, diry) = t_cot;
+   g->m.ter_set(dirx, diry, t_cot);
    it->invlet = 0;
   } else {
   g->add_msg("You can only place this indoors");
@@ -2378,7 +2380,7 @@ void iuse::dredge(game *g, player *p, item *it, bool t)
  {
   g->add_msg("You dredge for iron");
   p->moves -= (3000);
-  g->m.ter(dirx, diry) = t_dbog;
+  g->m.ter_set(dirx, diry, t_dbog);
   if (one_in(3)) {
    int irons = rng(2, 10);
    item iron(g->itypes[itm_iron], 0, g->nextinv);
@@ -2541,9 +2543,10 @@ void iuse::artifact(game *g, player *p, item *it, bool t)
    g->add_msg("The fabric of space seems to decay.");
    int x = rng(p->posx - 3, p->posx + 3), y = rng(p->posy - 3, p->posy + 3);
    if (g->m.field_at(x, y).type == fd_fatigue &&
-       g->m.field_at(x, y).density < 3)
+       g->m.field_at(x, y).density < 3) {
     g->m.field_at(x, y).density++;
-   else
+    g->m.touch_tile(x, y);	// Dense enough to block sight now
+   } else
     g->m.add_field(g, x, y, fd_fatigue, rng(1, 2));
   } break;
 
@@ -2553,9 +2556,10 @@ void iuse::artifact(game *g, player *p, item *it, bool t)
     for (int x = acidball.x - 1; x <= acidball.x + 1; x++) {
      for (int y = acidball.y - 1; y <= acidball.y + 1; y++) {
       if (g->m.field_at(x, y).type == fd_acid &&
-          g->m.field_at(x, y).density < 3)
+          g->m.field_at(x, y).density < 3) {
        g->m.field_at(x, y).density++;
-      else
+       g->m.touch_tile(x, y);
+      } else
        g->m.add_field(g, x, y, fd_acid, rng(2, 3));
      }
     }
@@ -2571,7 +2575,7 @@ void iuse::artifact(game *g, player *p, item *it, bool t)
      g->m.bash(x, y, 40, junk);  // Multibash effect, so that doors &c will fall
      g->m.bash(x, y, 40, junk);
      if (g->m.is_destructable(x, y) && rng(1, 10) >= 3)
-      g->m.ter(x, y) = t_rubble;
+      g->m.ter_set(x, y, t_rubble);
     }
    }
    break;
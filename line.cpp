@@ -3,59 +3,60 @@
 
 #define SGN(a) (((a)<0) ? -1 : 1)
 
-std::vector <point> line_to(int x1, int y1, int x2, int y2, int t)
+line_iterator::line_iterator(int x1, int y1, int x2, int y2, int T)
 {
- std::vector<point> ret;
  int dx = x2 - x1;
  int dy = y2 - y1;
- int ax = abs(dx)<<1;
- int ay = abs(dy)<<1;
- int sx = SGN(dx);
- int sy = SGN(dy);
- if (dy == 0) sy = 0;
- if (dx == 0) sx = 0;
- point cur;
- cur.x = x1;
- cur.y = y1;
-
- int xmin = (x1 < x2 ? x1 : x2), ymin = (y1 < y2 ? y1 : y2),
-     xmax = (x1 > x2 ? x1 : x2), ymax = (y1 > y2 ? y1 : y2);
+ x = x1;
+ y = y1;
+ tx = x2;
+ ty = y2;
+ t = T;
+ ax = abs(dx)<<1;
+ ay = abs(dy)<<1;
+ sx = (dx == 0 ? 0 : SGN(dx));
+ sy = (dy == 0 ? 0 : SGN(dy));
+ done = false;
 
- xmin -= abs(dx);
- ymin -= abs(dy);
- xmax += abs(dx);
- ymax += abs(dy);
+ xmin = (x1 < x2 ? x1 : x2) - abs(dx);
+ ymin = (y1 < y2 ? y1 : y2) - abs(dy);
+ xmax = (x1 > x2 ? x1 : x2) + abs(dx);
+ ymax = (y1 > y2 ? y1 : y2) + abs(dy);
+}
 
+bool line_iterator::next()
+{
+ if (done)
+  return false;
  if (ax == ay) {
-  do {
-   cur.y += sy;
-   cur.x += sx;
-   ret.push_back(cur);
-  } while ((cur.x != x2 || cur.y != y2) &&
-           (cur.x >= xmin && cur.x <= xmax && cur.y >= ymin && cur.y <= ymax));
+  y += sy;
+  x += sx;
  } else if (ax > ay) {
-  do {
-   if (t > 0) {
-    cur.y += sy;
-    t -= ax;
-   }
-   cur.x += sx;
-   t += ay;
-   ret.push_back(cur);
-  } while ((cur.x != x2 || cur.y != y2) &&
-           (cur.x >= xmin && cur.x <= xmax && cur.y >= ymin && cur.y <= ymax));
+  if (t > 0) {
+   y += sy;
+   t -= ax;
+  }
+  x += sx;
+  t += ay;
  } else {
-  do {
-   if (t > 0) {
-    cur.x += sx;
-    t -= ay;
-   }
-   cur.y += sy;
-   t += ax;
-   ret.push_back(cur);
-  } while ((cur.x != x2 || cur.y != y2) &&
-           (cur.x >= xmin && cur.x <= xmax && cur.y >= ymin && cur.y <= ymax));
+  if (t > 0) {
+   x += sx;
+   t -= ay;
+  }
+  y += sy;
+  t += ax;
  }
+ done = ((x == tx && y == ty) ||
+         x < xmin || x > xmax || y < ymin || y > ymax);
+ return true;
+}
+
+std::vector <point> line_to(int x1, int y1, int x2, int y2, int t)
+{
+ std::vector<point> ret;
+ line_iterator line(x1, y1, x2, y2, t);
+ while (line.next())
+  ret.push_back(point(line.x, line.y));
  return ret;
 }
 
@@ -18,6 +18,22 @@ WEST,
 NORTHWEST
 };
 
+// Walks the Bresenham line from (x1, y1) to (x2, y2) one point at a time,
+// without building a vector.  Each next() moves (x, y) one step, starting with
+// the first point past (x1, y1); it returns false once the line has reached
+// (x2, y2), or strayed too far from it for a bad t.
+class line_iterator
+{
+ public:
+  line_iterator(int x1, int y1, int x2, int y2, int t);
+  bool next();
+  int x, y;
+ private:
+  int tx, ty, t, ax, ay, sx, sy;
+  int xmin, xmax, ymin, ymax;
+  bool done;
+};
+
 // The "t" value decides WHICH Bresenham line is used.
 std::vector <point> line_to(int x1, int y1, int x2, int y2, int t);
 // sqrt(dX^2 + dY^2)
@@ -6,21 +6,70 @@
 #include <cmath>
 #include <stdlib.h>
 #include <fstream>
+#include <queue>
+#include <functional>
 
 #define SGN(a) (((a)<0) ? -1 : 1)
 #define INBOUNDS(x, y) \
  (x >= 0 && x < SEEX * my_MAPSIZE && y >= 0 && y < SEEY * my_MAPSIZE)
 
+// sees() remembers up to LOS_MEMO_MAX answers; LOS_BLOCKED marks a "no"
+#define LOS_MEMO_MAX 4096
+#define LOS_BLOCKED -999999
+
 enum astar_list {
  ASL_NONE,
  ASL_OPEN,
  ASL_CLOSED
 };
 
+// Flags kept in map::tile_bits
+enum tile_bit {
+ TB_TRANSPARENT = 1,
+ TB_BASHABLE    = 2,
+ TB_DOOR        = 4	// A closed door; cheap to get through
+};
+
+// Scratch space for map::route(), shared by every map and reused between
+// calls.  A cell only means anything if its stamp matches astar_gen, so
+// nothing needs clearing beforehand.
+#define ASTAR_W (SEEX * MAPSIZE)
+#define ASTAR_H (SEEY * MAPSIZE)
+unsigned int astar_gen = 0;
+unsigned int astar_stamp[ASTAR_W][ASTAR_H];
+astar_list   astar_state[ASTAR_W][ASTAR_H];
+int          astar_gscore[ASTAR_W][ASTAR_H];
+int          astar_score[ASTAR_W][ASTAR_H];
+int          astar_cost[ASTAR_W][ASTAR_H];	// -1 = impassable, -2 = unknown
+int          astar_seq[ASTAR_W][ASTAR_H];
+point        astar_parent[ASTAR_W][ASTAR_H];
+
+// Entries in the open heap; the lowest score comes out first, and ties go to
+// whichever was opened first, just as the old linear scan picked them.
+struct astar_node {
+ int score, seq, x, y;
+ astar_node(int S, int Q, int X, int Y) : score (S), seq (Q), x (X), y (Y) {}
+ bool operator< (const astar_node &b) const
+ {
+  return (score > b.score || (score == b.score && seq > b.seq));
+ }
+};
+
 map::map()
 {
  nulter = t_null;
  nultrap = tr_null;
+ seen_range = -1;
+ sight_range = -1;
+ sight_valid = false;
+ field_turn = -1;
+ field_pass = 0;
+ tile_cache_valid = false;
+ for (int n = 0; n < MAPSIZE * MAPSIZE; n++)
+  outside_valid[n] = false;
+ los_hits = 0;
+ los_misses = 0;
+ tile_gen = 0;
  if (is_tiny())
   my_MAPSIZE = 2;
  else
@@ -35,6 +84,17 @@ map::map(std::vector<itype*> *itptr, std::vector<itype_id> (*miptr)[num_itloc],
  itypes = itptr;
  mapitems = miptr;
  traps = trptr;
+ seen_range = -1;
+ sight_range = -1;
+ sight_valid = false;
+ field_turn = -1;
+ field_pass = 0;
+ tile_cache_valid = false;
+ for (int n = 0; n < MAPSIZE * MAPSIZE; n++)
+  outside_valid[n] = false;
+ los_hits = 0;
+ los_misses = 0;
+ tile_gen = 0;
  if (is_tiny())
   my_MAPSIZE = 2;
  else
@@ -182,6 +242,7 @@ bool map::displace_vehicle (game *g, int &x, int &y, int dx, int dy, bool test=f
     }
     veh.posx = dstx;
     veh.posy = dsty;
+    invalidate_cache();
     player *p = veh.get_driver (g);
     int rec = abs(veh.velocity) / 5 / 100;
     if (src_na != dst_na)
@@ -287,6 +348,7 @@ void map::vehmove(game *g)
                             unboard_vehicle (g, x, y);
                             // destroy vehicle (sank to nowhere)
                             grid[sm].vehicles.erase (grid[sm].vehicles.begin() + v);
+                            invalidate_cache();
                             v--;
                             break;
                         }
@@ -457,7 +519,10 @@ bool map::displace_water (int x, int y)
 ter_id& map::ter(int x, int y)
 {
  if (!INBOUNDS(x, y)) {
-  nulter = t_null;
+// Only put it back if someone wrote through it, so field jobs on other
+// threads can read out-of-bounds terrain at once
+  if (nulter != t_null)
+   nulter = t_null;
   return nulter;	// Out-of-bounds - null terrain 
  }
 /*
@@ -471,6 +536,98 @@ ter_id& map::ter(int x, int y)
  return grid[nonant].ter[x][y];
 }
 
+// Terrain worth remembering the location of; see map::find_terrain()
+bool is_feature(ter_id type)
+{
+ if (terlist[type].flags & (mfb(goes_up) | mfb(goes_down) | mfb(console)))
+  return true;
+ switch (type) {
+  case t_fault:
+  case t_elevator:
+  case t_elevator_control_off:
+  case t_sewage_pump:
+  case t_grate:
+  case t_root_wall:
+  case t_manhole_cover:
+  case t_radio_tower:
+  case t_rock_red:
+  case t_rock_green:
+  case t_rock_blue:
+  case t_floor_red:
+  case t_floor_green:
+  case t_floor_blue:
+   return true;
+  default:
+   return false;
+ }
+}
+
+void map::ter_set(int x, int y, ter_id new_terrain)
+{
+ if (!INBOUNDS(x, y))
+  return;
+ int nonant = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
+ grid[nonant].ter[x % SEEX][y % SEEY] = new_terrain;
+ touch_tile(x, y);
+ x %= SEEX;
+ y %= SEEY;
+ std::vector<point> &features = grid[nonant].features;
+ for (int i = 0; i < features.size(); i++) {
+  if (features[i].x == x && features[i].y == y) {
+   if (!is_feature(new_terrain))
+    features.erase(features.begin() + i);
+   return;
+  }
+ }
+ if (is_feature(new_terrain))
+  features.push_back(point(x, y));
+}
+
+std::vector<point> map::find_terrain(ter_id type)
+{
+ std::vector<point> ret;
+ if (!is_feature(type)) {
+  debugmsg("map::find_terrain(%s) - terrain isn't indexed!",
+           terlist[type].name.c_str());
+  return ret;
+ }
+// Entries go stale when ter() is written directly, so check each one
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  std::vector<point> &features = grid[n].features;
+  for (int i = 0; i < features.size(); i++) {
+   if (grid[n].ter[features[i].x][features[i].y] == type)
+    ret.push_back(point((n % my_MAPSIZE) * SEEX + features[i].x,
+                        (n / my_MAPSIZE) * SEEY + features[i].y));
+  }
+ }
+ return ret;
+}
+
+std::vector<point> map::find_terrain(t_flag flag)
+{
+ std::vector<point> ret;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  std::vector<point> &features = grid[n].features;
+  for (int i = 0; i < features.size(); i++) {
+   if (terlist[ grid[n].ter[features[i].x][features[i].y] ].flags & mfb(flag))
+    ret.push_back(point((n % my_MAPSIZE) * SEEX + features[i].x,
+                        (n / my_MAPSIZE) * SEEY + features[i].y));
+  }
+ }
+ return ret;
+}
+
+void map::index_features(int gridn)
+{
+ grid[gridn].features.clear();
+ for (int x = 0; x < SEEX; x++) {
+  for (int y = 0; y < SEEY; y++) {
+   if (is_feature(grid[gridn].ter[x][y]))
+    grid[gridn].features.push_back(point(x, y));
+  }
+ }
+}
+
 std::string map::tername(int x, int y)
 {
  return terlist[ter(x, y)].name;
@@ -494,6 +651,11 @@ std::string map::features(int x, int y)
 
 int map::move_cost(int x, int y)
 {
+ if (INBOUNDS(x, y)) {
+  if (!tile_cache_valid)
+   build_tile_cache();
+  return tile_cost[x][y];
+ }
  vehicle &veh = veh_at (x, y);
  if (veh.type != veh_null)
      return 8; // moving past vehicle cost 
@@ -510,6 +672,8 @@ bool map::trans(int x, int y)
  // Control statement is a problem. Normally returning false on an out-of-bounds
  // is how we stop rays from going on forever.  Instead we'll have to include
  // this check in the ray loop.
+ if (INBOUNDS(x, y))
+  return tile_flags(x, y) & TB_TRANSPARENT;
  return terlist[ter(x, y)].flags & mfb(transparent) &&
         (field_at(x, y).type == 0 ||	// Fields may obscure the view, too
         fieldlist[field_at(x, y).type].transparent[field_at(x, y).density - 1]);
@@ -526,27 +690,55 @@ bool map::is_destructable(int x, int y)
          (move_cost(x, y) == 0 && !has_flag(transparent, x, y)));
 }
 
+// A square is outside unless it or a neighbour has a roof (any floor), or it's
+// sheltered by a tent or awning
 bool map::is_outside(int x, int y)
 {
- return (ter(x    , y    ) != t_floor && ter(x - 1, y - 1) != t_floor &&
-         ter(x - 1, y    ) != t_floor && ter(x - 1, y + 1) != t_floor &&
-         ter(x    , y - 1) != t_floor && ter(x    , y    ) != t_floor &&
-         ter(x    , y + 1) != t_floor && ter(x + 1, y - 1) != t_floor &&
-         ter(x + 1, y    ) != t_floor && ter(x + 1, y + 1) != t_floor &&
-         ter(x    , y    ) != t_floor_wax &&
-         ter(x - 1, y - 1) != t_floor_wax &&
-         ter(x - 1, y    ) != t_floor_wax &&
-         ter(x - 1, y + 1) != t_floor_wax &&
-         ter(x    , y - 1) != t_floor_wax &&
-         ter(x    , y    ) != t_floor_wax &&
-         ter(x    , y + 1) != t_floor_wax &&
-         ter(x + 1, y - 1) != t_floor_wax &&
-         ter(x + 1, y    ) != t_floor_wax &&
-         ter(x + 1, y + 1) != t_floor_wax &&
-         ter(x, y        ) != t_groundsheet &&
-         ter(x, y        ) != t_awnsheet  &&
-         ter(x, y        ) != t_awnfloor  &&
-         ter(x, y        ) != t_support);
+ if (!INBOUNDS(x, y))
+  return true;
+ int n = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
+ if (!outside_valid[n])
+  build_outside_mask(n);
+ return outside_mask[n][y % SEEY] & (1 << (x % SEEX));
+}
+
+void map::build_outside_mask(int n)
+{
+ int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+// Bit x + 1 of roof[y + 1] is set if (x, y) is roofed, with a 1-square ring
+//  read from our neighbours
+ unsigned int roof[SEEY + 2];
+ unsigned short shelter[SEEY];
+ for (int y = -1; y <= SEEY; y++) {
+  roof[y + 1] = 0;
+  for (int x = -1; x <= SEEX; x++) {
+   ter_id t;
+   if (x >= 0 && x < SEEX && y >= 0 && y < SEEY)
+    t = grid[n].ter[x][y];
+   else
+    t = ter(offx + x, offy + y);
+   if (t == t_floor || t == t_floor_wax)
+    roof[y + 1] |= 1 << (x + 1);
+  }
+ }
+ for (int y = 0; y < SEEY; y++) {
+  shelter[y] = 0;
+  for (int x = 0; x < SEEX; x++) {
+   ter_id t = grid[n].ter[x][y];
+   if (t == t_groundsheet || t == t_awnsheet || t == t_awnfloor ||
+       t == t_support)
+    shelter[y] |= 1 << x;
+  }
+ }
+// Spread each roof over its 3x3, a row at a time
+ unsigned int wide[SEEY + 2];
+ for (int y = 0; y < SEEY + 2; y++)
+  wide[y] = roof[y] | (roof[y] << 1) | (roof[y] >> 1);
+ for (int y = 0; y < SEEY; y++) {
+  unsigned int covered = (wide[y] | wide[y + 1] | wide[y + 2]) >> 1;
+  outside_mask[n][y] = ~(covered | shelter[y]) & ((1 << SEEX) - 1);
+ }
+ outside_valid[n] = true;
 }
 
 bool map::flammable_items_at(int x, int y)
@@ -605,7 +797,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    int num_boards = rng(8, 20);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -619,7 +811,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
  case t_palgate_c:
   if (!(one_in(20)) && (str >= rng(0, 120))) {
    sound += "crash!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    int num_logs = rng(1, 2);
    for (int i = 0; i < num_logs; i++)
     add_item(x, y, (*itypes)[itm_log], 0);
@@ -636,7 +828,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "smash!";
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
    return true;
   } else {
    sound += "whump!";
@@ -648,7 +840,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_door_frame;
+   ter_set(x, y, t_door_frame);
    int num_boards = rng(2, 6);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -664,7 +856,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
    return true;
   } else {
    sound += "whack!";
@@ -676,7 +868,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_door_frame;
+   ter_set(x, y, t_door_frame);
    int num_boards = rng(0, 2);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -691,7 +883,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crash!";
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
    int num_boards = rng(0, 2) * rng(0, 1);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -706,7 +898,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
  case t_flap_c:
   if (str >= dice(2, 6) - 2) {
    sound += "rrrrip!";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    return true;
   } else {
    sound += "slap!";
@@ -718,7 +910,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "porcelain breaking!";
-   ter(x, y) = t_rubble;
+   ter_set(x, y, t_rubble);
    return true;
   } else {
    sound += "whunk!";
@@ -728,7 +920,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
  case t_counter:
   if (str >= dice(3, 16)) {
    sound += "smash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    int num_boards = rng(1, 5);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -742,7 +934,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
  case t_cot:
   if (str >= dice(6, 45)) {
    sound += "skree!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
     add_item(x, y, (*itypes)[itm_sheet], 0);
    int num_planks = rng(2, 8);
    for (int i = 0; i < num_planks; i++)
@@ -757,7 +949,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
  case t_rack:
   if (str >= dice(6, 45)) {
    sound += "skree!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    int num_pipes = rng(1, 6);
    for (int i = 0; i < num_pipes; i++)
     add_item(x, y, (*itypes)[itm_pipe], 0);
@@ -773,7 +965,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "smash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    int num_boards = rng(4, 12);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -792,7 +984,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "whack!";
@@ -805,7 +997,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "glass breaking!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "whack!";
@@ -817,7 +1009,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crunch!";
-   ter(x, y) = t_underbrush;
+   ter_set(x, y, t_underbrush);
    int num_sticks = rng(0, 3);
    for (int i = 0; i < num_sticks; i++)
     add_item(x, y, (*itypes)[itm_stick], 0);
@@ -832,7 +1024,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result && !one_in(4)) {
    sound += "crunch.";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    return true;
   } else {
    sound += "brush.";
@@ -844,7 +1036,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "crunch!";
-   ter(x, y) = t_fungus;
+   ter_set(x, y, t_fungus);
    return true;
   } else {
    sound += "whack!";
@@ -856,7 +1048,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "ker-rash!";
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    return true;
   } else {
    sound += "plunk.";
@@ -868,7 +1060,7 @@ bool map::bash(int x, int y, int str, std::string &sound, int *res)
   if (res) *res = result;
   if (str >= result) {
    sound += "smash";
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
    int num_boards = rng(1, 5);
    for (int i = 0; i < num_boards; i++)
     add_item(x, y, (*itypes)[itm_2x4], 0);
@@ -902,13 +1094,13 @@ void map::destroy(game *g, int x, int y, bool makesound)
       add_item(i, j, g->itypes[itm_steel_chunk], 0);
     }
    }
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
   break;
  case t_door_c:
  case t_door_b:
  case t_door_locked:
  case t_door_boarded:
-  ter(x, y) = t_door_frame;
+  ter_set(x, y, t_door_frame);
   for (int i = x - 2; i <= x + 2; i++) {
    for (int j = y - 2; j <= y + 2; j++) {
     if (move_cost(i, j) > 0 && one_in(6))
@@ -926,12 +1118,12 @@ void map::destroy(game *g, int x, int y, bool makesound)
      add_item(i, j, g->itypes[itm_2x4], 0);
    }
   }
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
   break;
  default:
   if (has_flag(explodes, x, y))
    g->explosion(x, y, 40, 0, true);
-  ter(x, y) = t_rubble;
+  ter_set(x, y, t_rubble);
  }
  if (makesound)
   g->sound(x, y, 40, "SMASH!!");
@@ -939,7 +1131,6 @@ void map::destroy(game *g, int x, int y, bool makesound)
 
 void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
 {
-
  if (has_flag(alarmed, x, y) && !g->event_queued(EVENT_WANTED)) {
   g->sound(g->u.posx, g->u.posy, 30, "An alarm sounds!");
   g->add_event(EVENT_WANTED, int(g->turn) + 300, 0, g->levx, g->levy);
@@ -977,14 +1168,14 @@ void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
  case t_door_locked_alarm:
   dam -= rng(15, 30);
   if (dam > 0)
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
   break;
 
  case t_door_b:
   if (hit_items || one_in(8)) {	// 1 in 8 chance of hitting the door
    dam -= rng(10, 30);
    if (dam > 0)
-    ter(x, y) = t_door_frame;
+    ter_set(x, y, t_door_frame);
   } else
    dam -= rng(0, 1);
   break;
@@ -992,19 +1183,19 @@ void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
  case t_door_boarded:
   dam -= rng(15, 35);
   if (dam > 0)
-   ter(x, y) = t_door_b;
+   ter_set(x, y, t_door_b);
   break;
 
  case t_window:
  case t_window_alarm:
   dam -= rng(0, 5);
-  ter(x, y) = t_window_frame;
+  ter_set(x, y, t_window_frame);
   break;
 
  case t_window_boarded:
   dam -= rng(10, 30);
   if (dam > 0)
-   ter(x, y) = t_window_frame;
+   ter_set(x, y, t_window_frame);
   break;
 
  case t_wall_glass_h:
@@ -1012,13 +1203,13 @@ void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
  case t_wall_glass_h_alarm:
  case t_wall_glass_v_alarm:
   dam -= rng(0, 8);
-  ter(x, y) = t_floor;
+  ter_set(x, y, t_floor);
   break;
 
  case t_paper:
   dam -= rng(4, 16);
   if (dam > 0)
-   ter(x, y) = t_dirt;
+   ter_set(x, y, t_dirt);
   if (flags & mfb(IF_AMMO_INCENDIARY))
    add_field(g, x, y, fd_fire, 1);
   break;
@@ -1036,7 +1227,7 @@ void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
       }
      }
     }
-    ter(x, y) = t_gas_pump_smashed;
+    ter_set(x, y, t_gas_pump_smashed);
    }
    dam -= 60;
   }
@@ -1045,7 +1236,7 @@ void map::shoot(game *g, int x, int y, int &dam, bool hit_items, unsigned flags)
  case t_vat:
   if (dam >= 10) {
    g->sound(x, y, 15, "ke-rash!");
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
   } else
    dam = 0;
   break;
@@ -1110,30 +1301,30 @@ bool map::hit_with_acid(game *g, int x, int y)
   case t_wall_glass_v_alarm:
   case t_wall_glass_h_alarm:
   case t_vat:
-   ter(x, y) = t_floor;
+   ter_set(x, y, t_floor);
    break;
 
   case t_door_c:
   case t_door_locked:
   case t_door_locked_alarm:
    if (one_in(3))
-    ter(x, y) = t_door_b;
+    ter_set(x, y, t_door_b);
    break;
 
   case t_door_b:
    if (one_in(4))
-    ter(x, y) = t_door_frame;
+    ter_set(x, y, t_door_frame);
    else
     return false;
    break;
 
   case t_window:
   case t_window_alarm:
-   ter(x, y) = t_window_empty;
+   ter_set(x, y, t_window_empty);
    break;
 
   case t_wax:
-   ter(x, y) = t_floor_wax;
+   ter_set(x, y, t_floor_wax);
    break;
 
   case t_toilet:
@@ -1143,7 +1334,7 @@ bool map::hit_with_acid(game *g, int x, int y)
 
   case t_card_science:
   case t_card_military:
-   ter(x, y) = t_card_reader_broken;
+   ter_set(x, y, t_card_reader_broken);
    break;
  }
 
@@ -1157,40 +1348,97 @@ void map::marlossify(int x, int y)
   case 1:
   case 2:
   case 3:
-  case 4: ter(x, y) = t_fungus;      break;
+  case 4: ter_set(x, y, t_fungus);      break;
   case 5:
   case 6:
-  case 7: ter(x, y) = t_marloss;     break;
-  case 8: ter(x, y) = t_tree_fungal; break;
-  case 9: ter(x, y) = t_slime;       break;
+  case 7: ter_set(x, y, t_marloss);     break;
+  case 8: ter_set(x, y, t_tree_fungal); break;
+  case 9: ter_set(x, y, t_slime);       break;
  }
 }
 
 bool map::open_door(int x, int y, bool inside)
 {
  if (ter(x, y) == t_door_c) {
-  ter(x, y) = t_door_o;
+  ter_set(x, y, t_door_o);
   return true;
  } else if (ter(x, y) == t_door_metal_c) {
-  ter(x, y) = t_door_metal_o;
+  ter_set(x, y, t_door_metal_o);
   return true;
  } else if (ter(x, y) == t_door_glass_c) {
-  ter(x, y) = t_door_glass_o;
+  ter_set(x, y, t_door_glass_o);
   return true;
  } else if (inside &&
             (ter(x, y) == t_door_locked || ter(x, y) == t_door_locked_alarm)) {
-  ter(x, y) = t_door_o;
+  ter_set(x, y, t_door_o);
   return true;
  } else if (ter(x, y) == t_flap_c) {
-  ter(x, y) = t_flap_o;
+  ter_set(x, y, t_flap_o);
   return true;
  } else if (ter(x, y) == t_palgate_c) {
-  ter(x, y) = t_palgate_o;
+  ter_set(x, y, t_palgate_o);
   return true;
  }
  return false;
 }
 
+map_iterator::map_iterator(submap *g, int size, int x1, int y1, int x2, int y2)
+{
+ grid = g;
+ mapsize = size;
+ if (x1 < 0)
+  x1 = 0;
+ if (y1 < 0)
+  y1 = 0;
+ if (x2 >= SEEX * mapsize)
+  x2 = SEEX * mapsize - 1;
+ if (y2 >= SEEY * mapsize)
+  y2 = SEEY * mapsize - 1;
+ x = x1;
+ miny = y1;
+ maxx = x2;
+ maxy = y2;
+ if (y1 > y2)	// Nothing in bounds; done() right away
+  x = maxx + 1;
+ if (!done())
+  start_column();
+}
+
+void map_iterator::start_column()
+{
+ y = miny;
+ lx = x % SEEX;
+ ly = y % SEEY;
+ cur = &(grid[x / SEEX + (y / SEEY) * mapsize]);
+}
+
+void map_iterator::next()
+{
+ if (y == maxy) {
+  x++;
+  if (!done())
+   start_column();
+  return;
+ }
+ y++;
+ ly++;
+ if (ly == SEEY) {	// Step down into the next submap
+  ly = 0;
+  cur += mapsize;
+ }
+}
+
+map_iterator map::rect(int x1, int y1, int x2, int y2)
+{
+ return map_iterator(grid, my_MAPSIZE, x1, y1, x2, y2);
+}
+
+map_iterator map::radius(int x, int y, int radius)
+{
+ return map_iterator(grid, my_MAPSIZE, x - radius, y - radius,
+                                       x + radius, y + radius);
+}
+
 void map::translate(ter_id from, ter_id to)
 {
  if (from == to) {
@@ -1201,7 +1449,7 @@ void map::translate(ter_id from, ter_id to)
  for (int x = 0; x < SEEX * my_MAPSIZE; x++) {
   for (int y = 0; y < SEEY * my_MAPSIZE; y++) {
    if (ter(x, y) == from)
-    ter(x, y) = to;
+    ter_set(x, y, to);
   }
  }
 }
@@ -1209,19 +1457,19 @@ void map::translate(ter_id from, ter_id to)
 bool map::close_door(int x, int y)
 {
  if (ter(x, y) == t_door_o) {
-  ter(x, y) = t_door_c;
+  ter_set(x, y, t_door_c);
   return true;
  } else if (ter(x, y) == t_door_metal_o) {
-  ter(x, y) = t_door_metal_c;
+  ter_set(x, y, t_door_metal_c);
   return true;
  } else if (ter(x, y) == t_door_glass_o) {
-  ter(x, y) = t_door_glass_c;
+  ter_set(x, y, t_door_glass_c);
   return true;
  } else if (ter(x, y) == t_flap_o) {
-  ter(x, y) = t_flap_c;
+  ter_set(x, y, t_flap_c);
   return true;
  } else if (ter(x, y) == t_palgate_o) {
-  ter(x, y) = t_palgate_c;
+  ter_set(x, y, t_palgate_c);
   return true;
  }
  return false;
@@ -1280,22 +1528,44 @@ void map::i_rem(int x, int y, int index)
 {
  if (index > i_at(x, y).size() - 1)
   return;
+// Everything after index moves down a place, so only the last address goes
+ item_locs.erase(&(i_at(x, y).back()));
  i_at(x, y).erase(i_at(x, y).begin() + index);
 }
 
 void map::i_clear(int x, int y)
 {
+ for (int i = 0; i < i_at(x, y).size(); i++)
+  item_locs.erase(&(i_at(x, y)[i]));
  i_at(x, y).clear();
 }
 
 point map::find_item(item *it)
 {
  point ret;
- for (ret.x = 0; ret.x < SEEX * my_MAPSIZE; ret.x++) {
-  for (ret.y = 0; ret.y < SEEY * my_MAPSIZE; ret.y++) {
-   for (int i = 0; i < i_at(ret.x, ret.y).size(); i++) {
-    if (it == &i_at(ret.x, ret.y)[i])
+ std::map<item*, point>::iterator hint = item_locs.find(it);
+ if (hint != item_locs.end()) {
+  ret = hint->second;
+  for (int i = 0; i < i_at(ret.x, ret.y).size(); i++) {
+   if (it == &i_at(ret.x, ret.y)[i])
+    return ret;
+  }
+  item_locs.erase(hint);	// Stale; fall back to a full scan
+ }
+// A stack holds it only if it lies within the stack's storage, so each square
+//  is one comparison rather than a walk through its items.  std::less gives a
+//  total order over pointers; plain < on unrelated arrays is undefined.
+ std::less<const item*> before;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  for (int x = 0; x < SEEX; x++) {
+   for (int y = 0; y < SEEY; y++) {
+    std::vector<item> &stack = grid[n].itm[x][y];
+    if (!stack.empty() && !before(it, &(stack[0])) &&
+        !before(&(stack.back()), it)) {
+     ret = point((n % my_MAPSIZE) * SEEX + x, (n / my_MAPSIZE) * SEEY + y);
+     item_locs[it] = ret;
      return ret;
+    }
    }
   }
  }
@@ -1304,6 +1574,30 @@ point map::find_item(item *it)
  return ret;
 }
 
+// Vehicle cargo isn't hinted; there are few enough vehicles to just look
+point map::find_vehicle_item(item *it, int &part)
+{
+ std::less<const item*> before;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+  for (int i = 0; i < grid[n].vehicles.size(); i++) {
+   vehicle &veh = grid[n].vehicles[i];
+   for (int p = 0; p < veh.parts.size(); p++) {
+    std::vector<item> &cargo = veh.parts[p].items;
+    if (cargo.empty() || before(it, &(cargo[0])) ||
+        before(&(cargo.back()), it))
+     continue;
+    int dx, dy;
+    veh.coord_translate(veh.parts[p].mount_dx, veh.parts[p].mount_dy, dx, dy);
+    part = p;
+    return point(offx + veh.posx + dx, offy + veh.posy + dy);
+   }
+  }
+ }
+ part = -1;
+ return point(-1, -1);
+}
+
 void map::add_item(int x, int y, itype* type, int birthday)
 {
  item tmp(type, birthday);
@@ -1352,8 +1646,11 @@ void map::add_item(int x, int y, item new_item)
  x %= SEEX;
  y %= SEEY;
  grid[nonant].itm[x][y].push_back(new_item);
- if (new_item.active)
+ if (new_item.active) {
   grid[nonant].active_item_count++;
+  item_locs[&(grid[nonant].itm[x][y].back())] =
+   point((nonant % my_MAPSIZE) * SEEX + x, (nonant / my_MAPSIZE) * SEEY + y);
+ }
 }
 
 void map::process_active_items(game *g)
@@ -1375,6 +1672,9 @@ void map::process_active_items_in_submap(game *g, int nonant)
    std::vector<item> *items = &(grid[nonant].itm[i][j]);
    for (int n = 0; n < items->size(); n++) {
     if ((*items)[n].active) {
+// The use function will likely want to know where it is; tell find_item()
+     item_locs[&((*items)[n])] = point((nonant % my_MAPSIZE) * SEEX + i,
+                                       (nonant / my_MAPSIZE) * SEEY + j);
      tmp = dynamic_cast<it_tool*>((*items)[n].type);
      (use.*tmp->use)(g, &(g->u), &((*items)[n]), true);
      if (tmp->turns_per_charge > 0 && int(g->turn) % tmp->turns_per_charge == 0)
@@ -1382,6 +1682,7 @@ void map::process_active_items_in_submap(game *g, int nonant)
      if ((*items)[n].charges <= 0) {
       (use.*tmp->use)(g, &(g->u), &((*items)[n]), false);
       if (tmp->revert_to == itm_null || (*items)[n].charges == -1) {
+       item_locs.erase(&((*items)[n]));
        items->erase(items->begin() + n);
        grid[nonant].active_item_count--;
        n--;
@@ -1561,22 +1862,20 @@ bool map::add_field(game *g, int x, int y, field_id t, unsigned char density)
 {
  if (!INBOUNDS(x, y))
   return false;
- if (field_at(x, y).type == fd_web && t == fd_fire)
+ field &fd = field_at(x, y);
+ if (fd.type == fd_web && t == fd_fire)
   density++;
- else if (!field_at(x, y).is_null()) // Blood & bile are null too
+ else if (!fd.is_null()) // Blood & bile are null too
   return false;
  if (density > 3)
   density = 3;
  if (density <= 0)
   return false;
- int nonant = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
- x %= SEEX;
- y %= SEEY;
- if (grid[nonant].fld[x][y].type == fd_null)
-  grid[nonant].field_count++;
- grid[nonant].fld[x][y] = field(t, density, 0);
- if (g != NULL && x == g->u.posx && y == g->u.posy &&
-     grid[nonant].fld[x][y].is_dangerous()) {
+ if (fd.type == fd_null)
+  grid[int(x / SEEX) + int(y / SEEY) * my_MAPSIZE].field_count++;
+ fd = field(t, density, 0);
+ touch_tile(x, y);
+ if (g != NULL && x == g->u.posx && y == g->u.posy && fd.is_dangerous()) {
   g->cancel_activity();
   g->add_msg("You're in a %s!", fieldlist[t].name[density - 1].c_str());
  }
@@ -1588,11 +1887,11 @@ void map::remove_field(int x, int y)
  if (!INBOUNDS(x, y))
   return;
  int nonant = int(x / SEEX) + int(y / SEEY) * my_MAPSIZE;
- x %= SEEX;
- y %= SEEY;
- if (grid[nonant].fld[x][y].type != fd_null)
+ field &fd = grid[nonant].fld[x % SEEX][y % SEEY];
+ if (fd.type != fd_null)
   grid[nonant].field_count--;
- grid[nonant].fld[x][y] = field();
+ fd = field();
+ touch_tile(x, y);
 }
 
 computer* map::computer_at(int x, int y)
@@ -1630,7 +1929,6 @@ void map::debug()
 
 void map::draw(game *g, WINDOW* w)
 {
- int t = 0;
  int light = g->u.sight_range(g->light_level());
  for  (int realx = g->u.posx - SEEX; realx <= g->u.posx + SEEX; realx++) {
   for (int realy = g->u.posy - SEEY; realy <= g->u.posy + SEEY; realy++) {
@@ -1641,7 +1939,7 @@ void map::draw(game *g, WINDOW* w)
     else
      mvwputch(w, realx+SEEX - g->u.posx, realy+SEEY - g->u.posy, c_dkgray, '#');
    } else if (dist <= g->u.clairvoyance() ||
-              sees(g->u.posx, g->u.posy, realx, realy, light, t))
+              pl_sees(g->u.posx, g->u.posy, realx, realy, light))
     drawsq(w, g->u, realx, realy, false, true);
   }
  }
@@ -1733,129 +2031,304 @@ void map::drawsq(WINDOW* w, player &u, int x, int y, bool invert,
 map::sees based off code by Steve Register [arns@arns.freeservers.com]
 http://roguebasin.roguelikedevelopment.org/index.php?title=Simple_Line_of_Sight
 */
+// The t values for lines from (0, 0) to (dx, dy) run from tmax * st down to
+// -st.  Doing it "backwards" prioritizes straight lines before diagonal.
+// This will help avoid creating a string of zombies behind you and will
+// promote "mobbing" behavior (zombies surround you to beat on you)
+static void line_t_range(int dx, int dy, int &st, int &tmax)
+{
+ int ax = abs(dx) << 1;
+ int ay = abs(dy) << 1;
+ if (ax > ay) { // Mostly-horizontal line
+  st = SGN(ay - (ax >> 1));
+  tmax = abs(ay - (ax >> 1)) * 2 + 1;
+ } else {	// Mostly-vertical line
+  st = SGN(ax - (ay >> 1));
+  tmax = abs(ax - (ay >> 1)) * 2 + 1;
+ }
+}
+
 bool map::sees(int Fx, int Fy, int Tx, int Ty, int range, int &tc)
 {
  int dx = Tx - Fx;
  int dy = Ty - Fy;
- int ax = abs(dx) << 1;
- int ay = abs(dy) << 1;
- int sx = SGN(dx);
- int sy = SGN(dy);
- int x = Fx;
- int y = Fy;
- int t = 0;
- int st;
- 
+ int st, tmax;
+
  if (range >= 0 && (abs(dx) > range || abs(dy) > range))
   return false;	// Out of range!
- if (ax > ay) { // Mostly-horizontal line
-  st = SGN(ay - (ax >> 1));
-// Doing it "backwards" prioritizes straight lines before diagonal.
-// This will help avoid creating a string of zombies behind you and will
-// promote "mobbing" behavior (zombies surround you to beat on you)
-  for (tc = abs(ay - (ax >> 1)) * 2 + 1; tc >= -1; tc--) {
-   t = tc * st;
-   x = Fx;
-   y = Fy;
-   do {
-    if (t > 0) {
-     y += sy;
-     t -= ax;
-    }
-    x += sx;
-    t += ay;
-    if (x == Tx && y == Ty) {
-     tc *= st;
-     return true;
-    }
-   } while ((trans(x, y)) && (INBOUNDS(x,y)));
+ if (dx == 0 && dy == 0)
+  return false;	// The line steps off our square before it looks for (Tx, Ty)
+ los_key key(Fx, Fy, Tx, Ty, range);
+ std::map<los_key, int>::iterator memo = los_memo.find(key);
+ if (memo != los_memo.end()) {
+  los_hits++;
+  if (memo->second == LOS_BLOCKED)
+   return false;
+  tc = memo->second;
+  return true;
+ }
+ los_misses++;
+ if (los_memo.size() >= LOS_MEMO_MAX)
+  los_memo.clear();
+ line_t_range(dx, dy, st, tmax);
+ for (tc = tmax; tc >= -1; tc--) {
+  line_iterator line(Fx, Fy, Tx, Ty, tc * st);
+  while (line.next()) {
+   if (line.x == Tx && line.y == Ty) {
+    tc *= st;
+    los_memo[key] = tc;
+    return true;
+   }
+   if (!trans(line.x, line.y) || !INBOUNDS(line.x, line.y))
+    break;
   }
+  if (dx == 0 || dy == 0 || abs(dx) == abs(dy))
+   break;	// Every t gives this same line
+ }
+ los_memo[key] = LOS_BLOCKED;
+ return false;
+}
+
+bool map::pl_sees(int Fx, int Fy, int Tx, int Ty, int range)
+{
+ if (!INBOUNDS(Tx, Ty) ||
+     (range >= 0 && (abs(Tx - Fx) > range || abs(Ty - Fy) > range)))
+  return false;	// Out of range!
+ if (seen_range == -1 || Fx != seen_x || Fy != seen_y ||
+     (seen_range < SEEX * my_MAPSIZE && (range < 0 || range > seen_range)))
+  build_seen_cache(Fx, Fy, range);
+ return seen_cache[Tx][Ty];
+}
+
+void map::sight_from(int Fx, int Fy, int range)
+{
+ if (range < 0 || range > SEEX * my_MAPSIZE)
+  range = SEEX * my_MAPSIZE;
+ if (sight_valid && Fx == sight_x && Fy == sight_y && range == sight_range)
+  return;
+ sight_x = Fx;
+ sight_y = Fy;
+ sight_range = range;
+ build_fov(sight_cache, Fx, Fy, range);
+ sight_valid = true;
+}
+
+bool map::in_sight(int Tx, int Ty)
+{
+ if (sight_range == -1 || !INBOUNDS(Tx, Ty) ||
+     abs(Tx - sight_x) > sight_range || abs(Ty - sight_y) > sight_range)
   return false;
- } else { // Same as above, for mostly-vertical lines
-  st = SGN(ax - (ay >> 1));
-  for (tc = abs(ax - (ay >> 1)) * 2 + 1; tc >= -1; tc--) {
-  t = tc * st;
-  x = Fx;
-  y = Fy;
-   do {
-    if (t > 0) {
-     x += sx;
-     t -= ay;
-    }
-    y += sy;
-    t += ax;
-    if (x == Tx && y == Ty) {
-     tc *= st;
-     return true;
-    }
-   } while ((trans(x, y)) && (INBOUNDS(x,y)));
+ if (!sight_valid) {	// Something changed since sight_from()
+  build_fov(sight_cache, sight_x, sight_y, sight_range);
+  sight_valid = true;
+ }
+ return sight_cache[Tx][Ty];
+}
+
+void map::invalidate_cache()
+{
+ tile_gen++;
+ seen_range = -1;
+ sight_valid = false;
+ tile_cache_valid = false;
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++)
+  outside_valid[n] = false;
+ los_memo.clear();
+}
+
+void map::touch_tile(int x, int y)
+{
+ bool same = false;
+ if (tile_cache_valid && INBOUNDS(x, y)) {
+  int cost = calc_tile_cost(x, y), bits = calc_tile_flags(x, y);
+  same = (cost == tile_cost[x][y] && bits == tile_bits[x][y]);
+  tile_cost[x][y] = cost;
+  tile_bits[x][y] = bits;
+ }
+ if (!same) {	// Blood and the like leave sight and pathing alone
+  tile_gen++;
+  seen_range = -1;
+  sight_valid = false;
+  los_memo.clear();
+ }
+// A roof here covers the squares around it, which may be in another submap
+ for (int dx = -1; dx <= 1; dx += 2) {
+  for (int dy = -1; dy <= 1; dy += 2) {
+   if (INBOUNDS(x + dx, y + dy))
+    outside_valid[int((x + dx) / SEEX) + int((y + dy) / SEEY) * my_MAPSIZE] =
+     false;
   }
-  return false;
  }
 }
 
+void map::build_tile_cache()
+{
+ for (int x = 0; x < SEEX * my_MAPSIZE; x++) {
+  for (int y = 0; y < SEEY * my_MAPSIZE; y++) {
+   tile_cost[x][y] = move_cost_ter_only(x, y);
+   tile_bits[x][y] = calc_tile_flags(x, y);
+  }
+ }
+// Vehicles override the terrain's move cost wherever they have a part
+ for (int n = 0; n < my_MAPSIZE * my_MAPSIZE; n++) {
+  int offx = (n % my_MAPSIZE) * SEEX, offy = (n / my_MAPSIZE) * SEEY;
+  for (int i = 0; i < grid[n].vehicles.size(); i++) {
+   vehicle &veh = grid[n].vehicles[i];
+   for (int p = 0; p < veh.parts.size(); p++) {
+    int dx, dy;
+    veh.coord_translate(veh.parts[p].mount_dx, veh.parts[p].mount_dy, dx, dy);
+    int x = offx + veh.posx + dx, y = offy + veh.posy + dy;
+    if (INBOUNDS(x, y))
+     tile_cost[x][y] = 8;
+   }
+  }
+ }
+ tile_cache_valid = true;
+}
+
+int map::tile_flags(int x, int y)
+{
+ if (!tile_cache_valid)
+  build_tile_cache();
+ return tile_bits[x][y];
+}
+
+// A vehicle part anywhere on (x, y) overrides the terrain's move cost
+int map::calc_tile_cost(int x, int y)
+{
+ if (veh_at(x, y).type != veh_null)
+  return 8;
+ return move_cost_ter_only(x, y);
+}
+
+// Works out the tile_bits for (x, y) from the terrain and field there
+int map::calc_tile_flags(int x, int y)
+{
+ int ret = 0;
+ ter_id terrain = ter(x, y);
+ field &fd = field_at(x, y);
+ if (terlist[terrain].flags & mfb(transparent) &&
+     (fd.type == 0 || fieldlist[fd.type].transparent[fd.density - 1]))
+  ret |= TB_TRANSPARENT;
+ if (terlist[terrain].flags & mfb(bashable))
+  ret |= TB_BASHABLE;
+ if (terrain == t_door_c)
+  ret |= TB_DOOR;
+ return ret;
+}
+
+// Floor division; C++ rounds negative quotients toward zero instead
+static int div_down(int n, int d)
+{
+ return (n >= 0 ? n / d : -((d - 1 - n) / d));
+}
+
+void map::build_seen_cache(int x, int y, int range)
+{
+ if (range < 0 || range > SEEX * my_MAPSIZE)
+  range = SEEX * my_MAPSIZE;
+ seen_x = x;
+ seen_y = y;
+ seen_range = range;
+ build_fov(seen_cache, x, y, range);
+}
+
+void map::build_fov(bool fov[SEEX * MAPSIZE][SEEY * MAPSIZE], int x, int y,
+                    int range)
+{
+// Only squares within range of (x, y) are ever read back
+ int minx = x - range, maxx = x + range, miny = y - range, maxy = y + range;
+ if (minx < 0) minx = 0;
+ if (miny < 0) miny = 0;
+ if (maxx >= SEEX * my_MAPSIZE) maxx = SEEX * my_MAPSIZE - 1;
+ if (maxy >= SEEY * my_MAPSIZE) maxy = SEEY * my_MAPSIZE - 1;
+ for (int i = minx; i <= maxx; i++) {
+  for (int j = miny; j <= maxy; j++)
+   fov[i][j] = false;
+ }
+ if (!INBOUNDS(x, y))
+  return;
+ fov[x][y] = true;
+ for (int quad = 0; quad < 4; quad++)
+  cast_fov(fov, x, y, quad, 1, range, -1, 1, 1, 1);
+}
+
+// Symmetric shadowcasting, one row of one quadrant at a time.  Rows are depth
+// steps away from (x, y); the visible arc of a row runs between the slopes
+// start_n/start_d and end_n/end_d.  Floor tiles are only marked seen when
+// their center lies inside the arc, so that if A sees B then B sees A.
+void map::cast_fov(bool fov[SEEX * MAPSIZE][SEEY * MAPSIZE], int x, int y,
+                   int quad, int depth, int range,
+                   int start_n, int start_d, int end_n, int end_d)
+{
+ if (depth > range)
+  return;
+ int min_col = div_down(2 * depth * start_n + start_d, 2 * start_d);
+ int max_col = -div_down(end_d - 2 * depth * end_n, 2 * end_d);
+ int prev = -1;	// -1 is nothing yet, 0 was floor, 1 was wall
+ for (int col = min_col; col <= max_col; col++) {
+  int tx, ty;
+  switch (quad) {
+   case 0: tx = x + col;   ty = y - depth; break;
+   case 1: tx = x + col;   ty = y + depth; break;
+   case 2: tx = x + depth; ty = y + col;   break;
+   default: tx = x - depth; ty = y + col;  break;
+  }
+  bool wall = (!INBOUNDS(tx, ty) || !trans(tx, ty));
+  if (INBOUNDS(tx, ty) &&
+      (wall || (col * start_d >= depth * start_n &&
+                col * end_d   <= depth * end_n)))
+   fov[tx][ty] = true;
+  if (prev == 1 && !wall) {
+   start_n = 2 * col - 1;
+   start_d = 2 * depth;
+  } else if (prev == 0 && wall)
+   cast_fov(fov, x, y, quad, depth + 1, range, start_n, start_d,
+            2 * col - 1, 2 * depth);
+  prev = (wall ? 1 : 0);
+ }
+ if (prev == 0)
+  cast_fov(fov, x, y, quad, depth + 1, range, start_n, start_d, end_n,
+           end_d);
+}
+
 bool map::clear_path(int Fx, int Fy, int Tx, int Ty, int range, int cost_min,
                      int cost_max, int &tc)
 {
  int dx = Tx - Fx;
  int dy = Ty - Fy;
- int ax = abs(dx) << 1;
- int ay = abs(dy) << 1;
- int sx = SGN(dx);
- int sy = SGN(dy);
- int x = Fx;
- int y = Fy;
- int t = 0;
- int st;
- 
+ int st, tmax;
+
  if (range >= 0 && (abs(dx) > range || abs(dy) > range))
   return false;	// Out of range!
- if (ax > ay) { // Mostly-horizontal line
-  st = SGN(ay - (ax >> 1));
-// Doing it "backwards" prioritizes straight lines before diagonal.
-// This will help avoid creating a string of zombies behind you and will
-// promote "mobbing" behavior (zombies surround you to beat on you)
-  for (tc = abs(ay - (ax >> 1)) * 2 + 1; tc >= -1; tc--) {
-   t = tc * st;
-   x = Fx;
-   y = Fy;
-   do {
-    if (t > 0) {
-     y += sy;
-     t -= ax;
-    }
-    x += sx;
-    t += ay;
-    if (x == Tx && y == Ty) {
-     tc *= st;
-     return true;
-    }
-   } while (move_cost(x, y) >= cost_min && move_cost(x, y) <= cost_max &&
-            INBOUNDS(x, y));
-  }
-  return false;
- } else { // Same as above, for mostly-vertical lines
-  st = SGN(ax - (ay >> 1));
-  for (tc = abs(ax - (ay >> 1)) * 2 + 1; tc >= -1; tc--) {
-  t = tc * st;
-  x = Fx;
-  y = Fy;
-   do {
-    if (t > 0) {
-     x += sx;
-     t -= ay;
-    }
-    y += sy;
-    t += ax;
-    if (x == Tx && y == Ty) {
-     tc *= st;
-     return true;
-    }
-   } while (move_cost(x, y) >= cost_min && move_cost(x, y) <= cost_max &&
-            INBOUNDS(x,y));
+ line_t_range(dx, dy, st, tmax);
+ for (tc = tmax; tc >= -1; tc--) {
+  line_iterator line(Fx, Fy, Tx, Ty, tc * st);
+  while (line.next()) {
+   if (line.x == Tx && line.y == Ty) {
+    tc *= st;
+    return true;
+   }
+   int cost = move_cost(line.x, line.y);
+   if (cost < cost_min || cost > cost_max || !INBOUNDS(line.x, line.y))
+    break;
   }
-  return false;
+  if (dx == 0 || dy == 0 || abs(dx) == abs(dy))
+   return false;	// Every t gives this same line
  }
+ return false;
+}
+
+// What it costs route() to step onto a tile, or -1 if it can't
+static int enter_cost(int cost, int bits, bool bash)
+{
+ if (cost == 0 && !(bash && (bits & TB_BASHABLE)))
+  return -1;
+ if (bits & TB_DOOR)
+  return cost + 4;	// A turn to open it and a turn to move there
+ if (cost == 0)
+  return 18;	// Worst case scenario with damage penalty
+ return cost;
 }
 
 // Bash defaults to true.
@@ -1878,6 +2351,20 @@ std::vector<point> map::route(int Fx, int Fy, int Tx, int Ty, bool bash)
  int linet = 0;
  if (clear_path(Fx, Fy, Tx, Ty, -1, 2, 2, linet))
   return line_to(Fx, Fy, Tx, Ty, linet);
+// Long trips are planned submap by submap; see long_route().  Passages only
+//  pair up squares straight across a border, so a way that only crosses
+//  diagonally, or at a corner, is left to the box.
+ if (abs(Fx / SEEX - Tx / SEEX) > 1 || abs(Fy / SEEY - Ty / SEEY) > 1) {
+  std::vector<point> ret = long_route(Fx, Fy, Tx, Ty, bash);
+  if (!ret.empty())
+   return ret;
+ }
+ return box_route(Fx, Fy, Tx, Ty, bash);
+}
+
+// A plain A* over the box around both ends, with a little room to go round
+std::vector<point> map::box_route(int Fx, int Fy, int Tx, int Ty, bool bash)
+{
 /*
  if (move_cost(Tx, Ty) == 0)
   debugmsg("%d:%d wanted to move to %d:%d, a %s!", Fx, Fy, Tx, Ty,
@@ -1886,11 +2373,6 @@ std::vector<point> map::route(int Fx, int Fy, int Tx, int Ty, bool bash)
   debugmsg("%d:%d, a %s, wanted to move to %d:%d!", Fx, Fy,
            tername(Fx, Fy).c_str(), Tx, Ty);
 */
- std::vector<point> open;
- astar_list list[SEEX * my_MAPSIZE][SEEY * my_MAPSIZE];
- int score	[SEEX * my_MAPSIZE][SEEY * my_MAPSIZE];
- int gscore	[SEEX * my_MAPSIZE][SEEY * my_MAPSIZE];
- point parent	[SEEX * my_MAPSIZE][SEEY * my_MAPSIZE];
  int startx = Fx - 4, endx = Tx + 4, starty = Fy - 4, endy = Ty + 4;
  if (Tx < Fx) {
   startx = Tx - 4;
@@ -1909,66 +2391,68 @@ std::vector<point> map::route(int Fx, int Fy, int Tx, int Ty, bool bash)
  if (endy > SEEY * my_MAPSIZE - 1)
   endy = SEEY * my_MAPSIZE - 1;
 
- for (int x = startx; x <= endx; x++) {
-  for (int y = starty; y <= endy; y++) {
-   list  [x][y] = ASL_NONE; // Init to not being on any list
-   score [x][y] = 0;        // No score!
-   gscore[x][y] = 0;        // No score!
-   parent[x][y] = point(-1, -1);
+ astar_gen++;
+ if (astar_gen == 0) {	// Wrapped around; old stamps could match again
+  for (int x = 0; x < ASTAR_W; x++) {
+   for (int y = 0; y < ASTAR_H; y++)
+    astar_stamp[x][y] = 0;
   }
- }
- list[Fx][Fy] = ASL_OPEN;
- open.push_back(point(Fx, Fy));
+  astar_gen = 1;
+ }
+ std::priority_queue<astar_node> open;
+ int next_seq = 0;
+ astar_stamp[Fx][Fy] = astar_gen;
+ astar_state[Fx][Fy] = ASL_OPEN;
+ astar_gscore[Fx][Fy] = 0;
+ astar_score[Fx][Fy] = 0;
+ astar_cost[Fx][Fy] = -2;
+ astar_seq[Fx][Fy] = next_seq;
+ open.push(astar_node(0, next_seq++, Fx, Fy));
 
  bool done = false;
 
- do {
-  //debugmsg("Open.size() = %d", open.size());
-  int best = 9999;
-  int index = -1;
-  for (int i = 0; i < open.size(); i++) {
-   if (i == 0 || score[open[i].x][open[i].y] < best) {
-    best = score[open[i].x][open[i].y];
-    index = i;
-   }
-  }
-  for (int x = open[index].x - 1; x <= open[index].x + 1; x++) {
-   for (int y = open[index].y - 1; y <= open[index].y + 1; y++) {
-    if (x == open[index].x && y == open[index].y)
+ while (!done && !open.empty()) {
+  astar_node cur = open.top();
+  open.pop();
+  if (astar_state[cur.x][cur.y] != ASL_OPEN)
+   continue;	// Stale entry; this square's been improved and closed already
+  for (int x = cur.x - 1; x <= cur.x + 1; x++) {
+   for (int y = cur.y - 1; y <= cur.y + 1; y++) {
+    if (x == cur.x && y == cur.y)
      y++;	// Skip the current square
     if (x == Tx && y == Ty) {
      done = true;
-     parent[x][y] = open[index];
-    } else if (x >= startx && x <= endx && y >= starty && y <= endy &&
-               (move_cost(x, y) > 0 || (bash && has_flag(bashable, x, y)))) {
-     if (list[x][y] == ASL_NONE) {	// Not listed, so make it open
-      list[x][y] = ASL_OPEN;
-      open.push_back(point(x, y));
-      parent[x][y] = open[index];
-      gscore[x][y] = gscore[open[index].x][open[index].y] + move_cost(x, y);
-      if (ter(x, y) == t_door_c)
-       gscore[x][y] += 4;	// A turn to open it and a turn to move there
-      else if (move_cost(x, y) == 0 && (bash && has_flag(bashable, x, y)))
-       gscore[x][y] += 18;	// Worst case scenario with damage penalty
-      score[x][y] = gscore[x][y] + 2 * rl_dist(x, y, Tx, Ty);
-     } else if (list[x][y] == ASL_OPEN) { // It's open, but make it our child
-      int newg = gscore[open[index].x][open[index].y] + move_cost(x, y);
-      if (ter(x, y) == t_door_c)
-       newg += 4;	// A turn to open it and a turn to move there
-      else if (move_cost(x, y) == 0 && (bash && has_flag(bashable, x, y)))
-       newg += 18;	// Worst case scenario with damage penalty
-      if (newg < gscore[x][y]) {
-       gscore[x][y] = newg;
-       parent[x][y] = open[index];
-       score [x][y] = gscore[x][y] + 2 * rl_dist(x, y, Tx, Ty);
-      }
-     }
+     astar_parent[x][y] = point(cur.x, cur.y);
+     continue;
+    }
+    if (x < startx || x > endx || y < starty || y > endy)
+     continue;
+    if (astar_stamp[x][y] != astar_gen) {
+     astar_stamp[x][y] = astar_gen;
+     astar_state[x][y] = ASL_NONE;
+     astar_cost[x][y] = -2;
+    }
+    if (astar_state[x][y] == ASL_CLOSED)
+     continue;
+    if (astar_cost[x][y] == -2) {	// Work out the cost of entering, once
+     astar_cost[x][y] = enter_cost(move_cost(x, y), tile_flags(x, y), bash);
     }
+    if (astar_cost[x][y] == -1)
+     continue;
+    int newg = astar_gscore[cur.x][cur.y] + astar_cost[x][y];
+    if (astar_state[x][y] == ASL_NONE) {	// Not listed, so make it open
+     astar_state[x][y] = ASL_OPEN;
+     astar_seq[x][y] = next_seq++;
+    } else if (newg >= astar_gscore[x][y])
+     continue;	// It's open, and we're no better a parent
+    astar_parent[x][y] = point(cur.x, cur.y);
+    astar_gscore[x][y] = newg;
+    astar_score[x][y] = newg + 2 * rl_dist(x, y, Tx, Ty);
+    open.push(astar_node(astar_score[x][y], astar_seq[x][y], x, y));
    }
   }
-  list[open[index].x][open[index].y] = ASL_CLOSED;
-  open.erase(open.begin() + index);
- } while (!done && open.size() > 0);
+  astar_state[cur.x][cur.y] = ASL_CLOSED;
+ }
 
  std::vector<point> tmp;
  std::vector<point> ret;
@@ -1977,12 +2461,12 @@ std::vector<point> map::route(int Fx, int Fy, int Tx, int Ty, bool bash)
   while (cur.x != Fx || cur.y != Fy) {
    //debugmsg("Retracing... (%d:%d) => [%d:%d] => (%d:%d)", Tx, Ty, cur.x, cur.y, Fx, Fy);
    tmp.push_back(cur);
-   if (rl_dist(cur.x, cur.y, parent[cur.x][cur.y].x, parent[cur.x][cur.y].y)>1){
-    debugmsg("Jump in our route! %d:%d->%d:%d", cur.x, cur.y,
-             parent[cur.x][cur.y].x, parent[cur.x][cur.y].y);
+   point par = astar_parent[cur.x][cur.y];
+   if (rl_dist(cur.x, cur.y, par.x, par.y) > 1) {
+    debugmsg("Jump in our route! %d:%d->%d:%d", cur.x, cur.y, par.x, par.y);
     return ret;
    }
-   cur = parent[cur.x][cur.y];
+   cur = par;
   }
   for (int i = tmp.size() - 1; i >= 0; i--)
    ret.push_back(tmp[i]);
@@ -1990,6 +2474,391 @@ std::vector<point> map::route(int Fx, int Fy, int Tx, int Ty, bool bash)
  return ret;
 }
 
+// Scratch space for local_route(); costs are -1 where it couldn't reach
+int   lr_dist[SEEX][SEEY];
+point lr_parent[SEEX][SEEY];
+
+// Scratch space for long_route()'s search over passages.  Node i of submap n
+// is n * ROUTE_NODES + i; the destination gets an id of its own.
+#define ROUTE_GOAL (MAPSIZE * MAPSIZE * ROUTE_NODES)
+unsigned int rt_gen = 0;
+unsigned int rt_stamp[ROUTE_GOAL + 1];
+bool rt_closed[ROUTE_GOAL + 1];
+int  rt_gscore[ROUTE_GOAL + 1];
+int  rt_parent[ROUTE_GOAL + 1];	// -1 = straight from the origin
+
+// Plans a long route in three passes.  First an A* over the passages between
+// submaps, using the cached costs of crossing each submap; then the pieces in
+// between are filled in tile by tile; and then smooth_route() straightens out
+// the kinks left by going through the middle of every passage.  Returns an
+// empty route if there is no way through the passages, and route() falls back
+// to box_route().
+std::vector<point> map::long_route(int Fx, int Fy, int Tx, int Ty, bool bash)
+{
+ std::vector<point> ret;
+ int b = (bash ? 1 : 0);
+ int ns = Fx / SEEX + (Fy / SEEY) * my_MAPSIZE;
+ int ng = Tx / SEEX + (Ty / SEEY) * my_MAPSIZE;
+ int gx = Tx % SEEX, gy = Ty % SEEY;
+ rt_gen++;
+ if (rt_gen == 0) {	// Wrapped around; old stamps could match again
+  for (int i = 0; i <= ROUTE_GOAL; i++)
+   rt_stamp[i] = 0;
+  for (int i = 0; i < MAPSIZE * MAPSIZE; i++)
+   route_caches[i].checked = 0;
+  rt_gen = 1;
+ }
+ check_route_cache(ns);
+ check_route_cache(ng);
+// How far each passage out of the goal's submap is from the goal itself
+ route_cache &rcg = route_caches[ng];
+ std::vector<int> to_goal;
+ local_route(ng, gx, gy, bash, true, gx, gy);
+ bool goal_open = false;
+ for (int i = 0; i < rcg.nodes.size(); i++) {
+  to_goal.push_back(lr_dist[rcg.nodes[i].x][rcg.nodes[i].y]);
+  goal_open |= (to_goal[i] >= 0);
+ }
+ if (!goal_open)
+  return ret;	// Walled in; no sense searching the whole map
+
+ std::priority_queue<astar_node> open;	// x is the node id; y is unused
+ int next_seq = 0;
+ route_cache &rcs = route_caches[ns];
+ local_route(ns, Fx % SEEX, Fy % SEEY, bash, false, -1, -1);
+ for (int i = 0; i < rcs.nodes.size(); i++) {
+  int d = lr_dist[rcs.nodes[i].x][rcs.nodes[i].y];
+  if (d < 0)
+   continue;
+  int id = ns * ROUTE_NODES + i;
+  int x = (ns % my_MAPSIZE) * SEEX + rcs.nodes[i].x,
+      y = (ns / my_MAPSIZE) * SEEY + rcs.nodes[i].y;
+  rt_stamp[id] = rt_gen;
+  rt_closed[id] = false;
+  rt_gscore[id] = d;
+  rt_parent[id] = -1;
+  open.push(astar_node(d + 2 * rl_dist(x, y, Tx, Ty), next_seq++, id, 0));
+ }
+
+ bool done = false;
+ while (!done && !open.empty()) {
+  astar_node cur = open.top();
+  open.pop();
+  int id = cur.x;
+  if (rt_closed[id])
+   continue;
+  rt_closed[id] = true;
+  if (id == ROUTE_GOAL) {
+   done = true;
+   break;
+  }
+  int n = id / ROUTE_NODES, i = id % ROUTE_NODES;
+  int g = rt_gscore[id];
+// Gather up where we can go from here, and what it costs
+  int next_ids[ROUTE_NODES + 2], next_costs[ROUTE_NODES + 2], num_next = 0;
+  if (n == ng && to_goal[i] >= 0) {
+   next_ids[num_next] = ROUTE_GOAL;
+   next_costs[num_next++] = to_goal[i];
+  }
+  route_dists(n, bash);
+  route_cache &rc = route_caches[n];
+  int count = rc.nodes.size();
+  for (int j = 0; j < count; j++) {
+   if (j != i && rc.dist[b][i * count + j] >= 0) {
+    next_ids[num_next] = n * ROUTE_NODES + j;
+    next_costs[num_next++] = rc.dist[b][i * count + j];
+   }
+  }
+  int n2, i2;
+  if (node_across(n, i, n2, i2)) {
+   point p = route_caches[n2].nodes[i2];
+   int cost = enter_cost(route_caches[n2].cost[p.x + 1][p.y + 1],
+                         route_caches[n2].bits[p.x + 1][p.y + 1], bash);
+   if (cost >= 0) {
+    next_ids[num_next] = n2 * ROUTE_NODES + i2;
+    next_costs[num_next++] = cost;
+   }
+  }
+  for (int k = 0; k < num_next; k++) {
+   int nid = next_ids[k], newg = g + next_costs[k];
+   if (rt_stamp[nid] != rt_gen) {
+    rt_stamp[nid] = rt_gen;
+    rt_closed[nid] = false;
+   } else if (rt_closed[nid] || newg >= rt_gscore[nid])
+    continue;
+   rt_gscore[nid] = newg;
+   rt_parent[nid] = id;
+   int h = 0;
+   if (nid != ROUTE_GOAL) {
+    int nn = nid / ROUTE_NODES;
+    point p = route_caches[nn].nodes[nid % ROUTE_NODES];
+    h = 2 * rl_dist((nn % my_MAPSIZE) * SEEX + p.x,
+                    (nn / my_MAPSIZE) * SEEY + p.y, Tx, Ty);
+   }
+   open.push(astar_node(newg + h, next_seq++, nid, 0));
+  }
+ }
+ if (!done)
+  return ret;
+
+// Now walk it back, and fill in each leg tile by tile.  A straight line or the
+// boxed A* usually gets there without searching the whole submap; where the
+// way round leaves its box, the submap's own search can't miss.
+ std::vector<int> legs;
+ for (int id = rt_parent[ROUTE_GOAL]; id != -1; id = rt_parent[id])
+  legs.insert(legs.begin(), id);
+ int n = ns, x = Fx % SEEX, y = Fy % SEEY;
+ for (int k = 0; k <= legs.size(); k++) {
+  int n2 = ng, x2 = gx, y2 = gy;
+  if (k < legs.size()) {
+   n2 = legs[k] / ROUTE_NODES;
+   x2 = route_caches[n2].nodes[legs[k] % ROUTE_NODES].x;
+   y2 = route_caches[n2].nodes[legs[k] % ROUTE_NODES].y;
+  }
+  int offx = (n2 % my_MAPSIZE) * SEEX, offy = (n2 / my_MAPSIZE) * SEEY;
+  if (n2 != n)	// Stepping over into the next submap
+   ret.push_back(point(offx + x2, offy + y2));
+  else if (x2 != x || y2 != y) {
+   std::vector<point> leg;
+   int linet = 0;
+   if (clear_path(offx + x, offy + y, offx + x2, offy + y2, -1, 2, 2, linet))
+    leg = line_to(offx + x, offy + y, offx + x2, offy + y2, linet);
+   else
+    leg = box_route(offx + x, offy + y, offx + x2, offy + y2, bash);
+   if (leg.empty()) {
+    local_route(n, x, y, bash, false, (k == legs.size() ? gx : -1), gy);
+    if (lr_dist[x2][y2] < 0) {
+     debugmsg("long_route() lost its way in submap %d!", n);
+     ret.clear();
+     return ret;
+    }
+    for (point p(x2, y2); p.x != x || p.y != y; p = lr_parent[p.x][p.y])
+     leg.insert(leg.begin(), point(offx + p.x, offy + p.y));
+   }
+   ret.insert(ret.end(), leg.begin(), leg.end());
+  }
+  n = n2;
+  x = x2;
+  y = y2;
+ }
+ smooth_route(Fx, Fy, ret, bash);
+ return ret;
+}
+
+// Goes along a path from (Fx, Fy) a short stretch at a time, asking
+// box_route() for the best way to a point ROUTE_SPAN steps ahead.  Where that
+// beats the path, it takes its place.  Only the first half of each stretch is
+// kept before the next one starts, so the joins get straightened out too.
+// Each boxed search covers only a submap or so, and the path never gets any
+// dearer.
+#define ROUTE_SPAN SEEX
+void map::smooth_route(int Fx, int Fy, std::vector<point> &path, bool bash)
+{
+ std::vector<point> ret, rest, seg;
+ rest.swap(path);
+ point from(Fx, Fy);
+ while (!rest.empty()) {
+  int end = (rest.size() < ROUTE_SPAN ? rest.size() : ROUTE_SPAN) - 1;
+  point to = rest[end];
+  if (to.x == from.x && to.y == from.y) {	// It loops back; cut it out
+   rest.erase(rest.begin(), rest.begin() + end + 1);
+   continue;
+  }
+  int linet = 0;
+// Both end on the same point, so leave its cost out of the comparison.  No
+// step costs less than 2, so a stretch that cheap is as good as it gets.
+  int old_cost = route_cost(rest, 0, end, bash);
+  if (old_cost <= 2 * (rl_dist(from.x, from.y, to.x, to.y) - 1))
+   seg.clear();
+  else if (clear_path(from.x, from.y, to.x, to.y, -1, 2, 2, linet))
+   seg = line_to(from.x, from.y, to.x, to.y, linet);
+  else
+   seg = box_route(from.x, from.y, to.x, to.y, bash);
+  if (seg.empty() || route_cost(seg, 0, seg.size() - 1, bash) > old_cost)
+   seg.assign(rest.begin(), rest.begin() + end + 1);
+  if (end == rest.size() - 1) {
+   ret.insert(ret.end(), seg.begin(), seg.end());
+   break;
+  }
+  int keep = (seg.size() + 1) / 2;
+  ret.insert(ret.end(), seg.begin(), seg.begin() + keep);
+  from = seg[keep - 1];
+  seg.erase(seg.begin(), seg.begin() + keep);
+  rest.erase(rest.begin(), rest.begin() + end + 1);
+  rest.insert(rest.begin(), seg.begin(), seg.end());
+ }
+ path.swap(ret);
+}
+
+// What route() pays to walk path[from] to path[to - 1]
+int map::route_cost(std::vector<point> &path, int from, int to, bool bash)
+{
+ int ret = 0;
+ for (int i = from; i < to; i++)
+  ret += enter_cost(move_cost(path[i].x, path[i].y),
+                    tile_flags(path[i].x, path[i].y), bash);
+ return ret;
+}
+
+// Makes sure submap n's route cache matches the map, rebuilding it if not
+void map::check_route_cache(int n)
+{
+ route_cache &rc = route_caches[n];
+ if (rc.valid && (rc.checked == rt_gen || rc.gen == tile_gen))
+  return;	// Already checked during this search, or nothing's changed since
+ rc.checked = rt_gen;
+ rc.gen = tile_gen;
+ int offx = (n % my_MAPSIZE) * SEEX - 1, offy = (n / my_MAPSIZE) * SEEY - 1;
+ bool same = rc.valid;
+ if (!tile_cache_valid)
+  build_tile_cache();
+ for (int i = 0; i < SEEX + 2; i++) {
+  for (int j = 0; j < SEEY + 2; j++) {
+   int x = offx + i, y = offy + j;
+   unsigned char cost = 0, bits = 0;
+   if (!INBOUNDS(x, y))
+    ;	// Off the map; nothing can get through
+   else {
+    cost = tile_cost[x][y];
+    bits = tile_bits[x][y] & (TB_BASHABLE | TB_DOOR);
+   }
+   if (cost != rc.cost[i][j] || bits != rc.bits[i][j]) {
+    same = false;
+    rc.cost[i][j] = cost;
+    rc.bits[i][j] = bits;
+   }
+  }
+ }
+ if (same)
+  return;
+ rc.valid = true;
+ rc.have_dist[0] = false;
+ rc.have_dist[1] = false;
+ rc.nodes.clear();
+ rc.sides.clear();
+// Each run of tiles that are open on both sides of a border gets one node, in
+// its middle.  The submap across finds the same runs, so the nodes pair up.
+ int gridx = n % my_MAPSIZE, gridy = n / my_MAPSIZE;
+ for (int side = 0; side < 4; side++) {	// North, east, south, west
+  if ((side == 0 && gridy == 0) || (side == 1 && gridx == my_MAPSIZE - 1) ||
+      (side == 2 && gridy == my_MAPSIZE - 1) || (side == 3 && gridx == 0))
+   continue;	// Nothing over there to go to
+  int len = (side % 2 == 0 ? SEEX : SEEY), run = -1;
+  for (int k = 0; k <= len; k++) {
+   bool open = false;
+   int x = 0, y = 0, ax = 0, ay = 0;	// Ring coordinates, ours & across
+   switch (side) {
+    case 0: x = k + 1; y = 1;    ax = x; ay = 0;        break;
+    case 1: x = SEEX;  y = k + 1; ax = SEEX + 1; ay = y; break;
+    case 2: x = k + 1; y = SEEY; ax = x; ay = SEEY + 1; break;
+    case 3: x = 1;     y = k + 1; ax = 0; ay = y;        break;
+   }
+   if (k < len)
+    open = ((rc.cost[x][y] > 0 || (rc.bits[x][y] & TB_BASHABLE)) &&
+            (rc.cost[ax][ay] > 0 || (rc.bits[ax][ay] & TB_BASHABLE)));
+   if (open && run == -1)
+    run = k;
+   else if (!open && run != -1) {
+    int mid = (run + k - 1) / 2;
+    switch (side) {
+     case 0: rc.nodes.push_back(point(mid, 0));        break;
+     case 1: rc.nodes.push_back(point(SEEX - 1, mid)); break;
+     case 2: rc.nodes.push_back(point(mid, SEEY - 1)); break;
+     case 3: rc.nodes.push_back(point(0, mid));        break;
+    }
+    rc.sides.push_back(side);
+    run = -1;
+   }
+  }
+ }
+}
+
+// Fills in the costs between every pair of submap n's nodes
+void map::route_dists(int n, bool bash)
+{
+ route_cache &rc = route_caches[n];
+ int b = (bash ? 1 : 0), count = rc.nodes.size();
+ if (rc.have_dist[b])
+  return;
+ rc.dist[b].assign(count * count, -1);
+ for (int i = 0; i < count; i++) {
+  local_route(n, rc.nodes[i].x, rc.nodes[i].y, bash, false, -1, -1);
+  for (int j = 0; j < count; j++)
+   rc.dist[b][i * count + j] = lr_dist[rc.nodes[j].x][rc.nodes[j].y];
+ }
+ rc.have_dist[b] = true;
+}
+
+// Finds the node paired with node i of submap n, on the far side of its border
+bool map::node_across(int n, int i, int &n2, int &i2)
+{
+ point p = route_caches[n].nodes[i];
+ int side = route_caches[n].sides[i];
+ switch (side) {
+  case 0: n2 = n - my_MAPSIZE; p.y = SEEY - 1; break;
+  case 1: n2 = n + 1;          p.x = 0;        break;
+  case 2: n2 = n + my_MAPSIZE; p.y = 0;        break;
+  case 3: n2 = n - 1;          p.x = SEEX - 1; break;
+ }
+ check_route_cache(n2);
+ route_cache &rc = route_caches[n2];
+ for (i2 = 0; i2 < rc.nodes.size(); i2++) {
+  if (rc.sides[i2] == (side + 2) % 4 &&
+      rc.nodes[i2].x == p.x && rc.nodes[i2].y == p.y)
+   return true;
+ }
+ return false;
+}
+
+// Dijkstra within submap n from local tile (x, y), into lr_dist & lr_parent,
+// using the costs in its route cache.  With reverse set, lr_dist holds the
+// cost of getting from each tile to (x, y) instead.  Stepping onto
+// (goalx, goaly) is free, as route() lets us end on any square.
+void map::local_route(int n, int x, int y, bool bash, bool reverse,
+                      int goalx, int goaly)
+{
+ route_cache &rc = route_caches[n];
+ for (int i = 0; i < SEEX; i++) {
+  for (int j = 0; j < SEEY; j++)
+   lr_dist[i][j] = -1;
+ }
+ std::priority_queue<astar_node> open;
+ int next_seq = 0;
+ lr_dist[x][y] = 0;
+ open.push(astar_node(0, next_seq++, x, y));
+ while (!open.empty()) {
+  astar_node cur = open.top();
+  open.pop();
+  if (cur.score > lr_dist[cur.x][cur.y])
+   continue;	// Stale entry
+  int leave = 0;
+  if (reverse && (cur.x != goalx || cur.y != goaly)) {
+   leave = enter_cost(rc.cost[cur.x + 1][cur.y + 1],
+                      rc.bits[cur.x + 1][cur.y + 1], bash);
+   if (leave < 0)
+    continue;
+  }
+  for (int i = cur.x - 1; i <= cur.x + 1; i++) {
+   for (int j = cur.y - 1; j <= cur.y + 1; j++) {
+    if (i < 0 || i >= SEEX || j < 0 || j >= SEEY || (i == cur.x && j == cur.y))
+     continue;
+    int cost = leave;
+    if (!reverse && (i != goalx || j != goaly)) {
+     cost = enter_cost(rc.cost[i + 1][j + 1], rc.bits[i + 1][j + 1], bash);
+     if (cost < 0)
+      continue;
+    }
+    int newd = cur.score + cost;
+    if (lr_dist[i][j] == -1 || newd < lr_dist[i][j]) {
+     lr_dist[i][j] = newd;
+     lr_parent[i][j] = point(cur.x, cur.y);
+     open.push(astar_node(newd, next_seq++, i, j));
+    }
+   }
+  }
+ }
+}
+
 void map::save(overmap *om, unsigned int turn, int x, int y)
 {
  for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
@@ -2000,18 +2869,24 @@ void map::save(overmap *om, unsigned int turn, int x, int y)
 
 void map::load(game *g, int wx, int wy)
 {
+ item_locs.clear();
  for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
   for (int gridy = 0; gridy < my_MAPSIZE; gridy++) {
    if (!loadn(g, wx, wy, gridx, gridy))
     loadn(g, wx, wy, gridx, gridy);
   }
  }
+// Not before: catching up on fields in loadn() rebuilds the caches from
+//  whatever was loaded so far
+ invalidate_cache();
 }
 
 void map::shift(game *g, int wx, int wy, int sx, int sy)
 {
+ item_locs.clear();	// Submaps are about to be copied around
 // Special case of 0-shift; refresh the map
  if (sx == 0 && sy == 0) {
+  invalidate_cache();
   return; // Skip this?
   for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
    for (int gridy = 0; gridy < my_MAPSIZE; gridy++) {
@@ -2085,6 +2960,7 @@ void map::shift(game *g, int wx, int wy, int sx, int sy)
    }
   }
  }
+ invalidate_cache();	// Only now is every submap in place; see load()
 }
 
 // saven saves a single nonant.  worldx and worldy are used for the file
@@ -2277,7 +3153,9 @@ bool map::loadn(game *g, int worldx, int worldy, int gridx, int gridy)
    }
   }
   mapin.close();
+  index_features(gridn);
   if (fields_here && turndif >= 8) {
+   invalidate_cache();	// Its terrain came straight into grid[]
    for (int i = 0; i < int(turndif / 8) && i < 5000; i++) {
     if (!process_fields(g))
      i = int(turndif / 8) + 1;
@@ -2324,6 +3202,7 @@ void map::copy_grid(int to, int from)
  }
 
  grid[to].comp = grid[from].comp;
+ grid[to].features = grid[from].features;
 // Not needed?
 /*
  grid[to].spawns.clear();
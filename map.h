@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <vector>
 #include <string>
+#include <map>
+#include <set>
 
 #include "mapdata.h"
 #include "mapitems.h"
@@ -25,6 +27,113 @@ class player;
 class item;
 struct itype;
 
+/* Walks the in-bounds tiles of a rectangle in the same order as the usual
+ *  for (x = x1; x <= x2; x++) { for (y = y1; y <= y2; y++) {
+ * loop, but reads the submaps directly instead of bounds-checking and
+ * dividing by SEEX/SEEY on every access.  Get one from map::rect() or
+ * map::radius(), then:
+ *  for (map_iterator it = g->m.rect(x1, y1, x2, y2); !it.done(); it.next())
+ * Writing ter() or fld() through it bypasses ter_set() and field_count, just
+ * as writing through map::ter() and map::field_at() does.
+ */
+class map_iterator
+{
+ public:
+  int x, y; // Current tile
+
+  bool done() { return x > maxx; }
+  void next();
+
+  ter_id& ter()              { return cur->ter[lx][ly]; }
+  std::vector<item>& items() { return cur->itm[lx][ly]; }
+  field& fld()               { return cur->fld[lx][ly]; }
+  trap_id& trap()            { return cur->trp[lx][ly]; }
+  int& radiation()           { return cur->rad[lx][ly]; }
+  bool has_flag(t_flag flag) { return terlist[ter()].flags & mfb(flag); }
+
+ private:
+  friend class map;
+  map_iterator(submap *g, int mapsize, int x1, int y1, int x2, int y2);
+  void start_column();
+
+  submap *grid, *cur;
+  int mapsize;
+  int miny, maxx, maxy;
+  int lx, ly;
+};
+
+// Endpoints and range of a sees() query, for memoizing the answer
+struct los_key {
+ int Fx, Fy, Tx, Ty, range;
+ los_key(int fx, int fy, int tx, int ty, int r)
+  : Fx (fx), Fy (fy), Tx (tx), Ty (ty), range (r) {}
+ bool operator< (const los_key &b) const
+ {
+  if (Fx != b.Fx) return Fx < b.Fx;
+  if (Fy != b.Fy) return Fy < b.Fy;
+  if (Tx != b.Tx) return Tx < b.Tx;
+  if (Ty != b.Ty) return Ty < b.Ty;
+  return range < b.range;
+ }
+};
+
+// What map::route() knows about one submap for planning long trips: where
+// the passages to its neighbours are, and what it costs to cross between
+// them.  Tiles are in submap-local coordinates and everything is worked out
+// from the snapshot alone, so the cache holds for as long as the snapshot
+// still matches the map.
+#define ROUTE_NODES 24	// At most six passages on each side
+struct route_cache {
+ bool valid;
+ unsigned char cost[SEEX + 2][SEEY + 2];	// tile_cost, with a 1-tile ring
+ unsigned char bits[SEEX + 2][SEEY + 2];	// tile_bits, likewise
+ std::vector<point> nodes;	// Our side of each passage
+ std::vector<int> sides;	// Which border each node is on; see node_across()
+ std::vector<int> dist[2];	// [bash][from * nodes + to]; -1 means no way
+ bool have_dist[2];
+ unsigned int checked;	// The long_route() call that last checked us
+ int gen;		// map::tile_gen as of then
+ route_cache() : valid (false), checked (0), gen (-1) {}
+};
+
+// How many threads process_fields() shares its submaps out between; building
+//  with -DFIELD_THREADS=1 runs them one after another, for debugging
+#ifndef FIELD_THREADS
+#define FIELD_THREADS 4
+#endif
+
+// Something one square's field does to another square, held back until every
+// square has had its turn in process_fields(); see field.cpp
+enum field_change_type {
+ FC_ADD,	// add_field(type, density)
+ FC_GAS,	// Gas drifts in: thicken our own kind, or fill an empty square;
+		// if it can't, it goes back to (srcx, srcy)
+ FC_CONVERT,	// Turn a weaker gas into type
+ FC_THICKEN,	// density++ if it's still type; age = age unless age < 0
+ FC_IGNITE,	// Smoke and webs become fire, anything else gets add_field()
+ FC_TERRAIN,	// ter_set(ter)
+ FC_DETONATE,	// Set off explodes terrain, if it hasn't gone off already
+ FC_VEH_EXPLODE,	// Blow up the vehicle's fuel tank
+ FC_SPAWN,	// A nether creature comes through the fatigue field
+ FC_SCENT	// Gas clears the scent here
+};
+
+struct field_jobs;	// See field.cpp
+
+struct field_change {
+ field_change_type kind;
+ int x, y;
+ field_id type;
+ int density, age;
+ ter_id ter;
+ mon_id mon;
+ int srcx, srcy;
+ field_change(field_change_type k, int X, int Y, field_id t = fd_null,
+              int d = 1, int a = 0, ter_id tr = t_null)
+  : kind (k), x (X), y (Y), type (t), density (d), age (a), ter (tr),
+    mon (mon_null), srcx (-1), srcy (-1) {}
+};
+
 class map
 {
  public:
@@ -53,6 +162,18 @@ class map
  // tc indicates the Bresenham line used to connect the two points, and may
  //  subsequently be used to form a path between them
  bool sees(int Fx, int Fy, int Tx, int Ty, int range, int &tc);
+// pl_sees answers the same question from a shadowcast field of view around
+//  (Fx, Fy), which is kept until the origin moves or invalidate_cache()
+ bool pl_sees(int Fx, int Fy, int Tx, int Ty, int range);
+// For checking many targets from one origin: sight_from() casts the same kind
+//  of field of view into a scratch map of its own, and in_sight() then answers
+//  for any number of targets without a line to each
+ void sight_from(int Fx, int Fy, int range);
+ bool in_sight(int Tx, int Ty);
+ void invalidate_cache(); // Call after changing terrain, fields or vehicles
+ void touch_tile(int x, int y); // Call after changing the field at (x, y)
+ int los_hits, los_misses; // How often sees() was answered from its memo
+ int tile_gen; // Bumped whenever a square's move cost or flags may change
 // clear_path is the same idea, but uses cost_min <= move_cost <= cost_max
  bool clear_path(int Fx, int Fy, int Tx, int Ty, int range, int cost_min,
                  int cost_max, int &tc);
@@ -75,6 +196,13 @@ class map
 
 // Terrain
  ter_id& ter(int x, int y); // Terrain at coord (x, y); {x|y}=(0, SEE{X|Y}*3]
+// Use ter_set() rather than ter() = when placing stairs, consoles &c at
+// runtime, so that find_terrain() can see them
+ void ter_set(int x, int y, ter_id new_terrain);
+// All points with the given terrain; only works for the few types listed in
+// is_feature() (map.cpp), but avoids scanning the whole map
+ std::vector<point> find_terrain(ter_id type);
+ std::vector<point> find_terrain(t_flag flag); // goes_up, goes_down or console
  std::string tername(int x, int y); // Name of terrain at (x, y)
  std::string features(int x, int y); // Words relevant to terrain (sharp, etc)
  bool has_flag(t_flag flag, int x, int y);
@@ -83,6 +211,11 @@ class map
  bool flammable_items_at(int x, int y);
  point random_outdoor_tile();
 
+// Tiles from (x1, y1) to (x2, y2) inclusive, or within rl_dist radius of
+//  (x, y), clipped to the map; see map_iterator above
+ map_iterator rect(int x1, int y1, int x2, int y2);
+ map_iterator radius(int x, int y, int radius);
+
  void translate(ter_id from, ter_id to); // Change all instances of $from->$to
  bool close_door(int x, int y);
  bool open_door(int x, int y, bool inside);
@@ -101,6 +234,7 @@ class map
  void i_clear(int x, int y);
  void i_rem(int x, int y, int index);
  point find_item(item *it);
+ point find_vehicle_item(item *it, int &part); // (-1, -1) if in no vehicle
  void add_item(int x, int y, itype* type, int birthday);
  void add_item(int x, int y, item new_item);
  void process_active_items(game *g);
@@ -122,6 +256,8 @@ class map
  void remove_field(int x, int y);
  bool process_fields(game *g);				// See fields.cpp
  bool process_fields_in_submap(game *g, int gridn);	// See fields.cpp
+ void age_fields(game *g, int turns);	// Decay only, for skipped turns
+ bool fields_near(int x, int y, int radius); // Any in submaps within radius?
  void step_in_field(int x, int y, game *g);		// See fields.cpp
  void mon_in_field(int x, int y, game *g, monster *z);	// See fields.cpp
 
@@ -144,6 +280,38 @@ protected:
  void saven(overmap *om, unsigned int turn, int x, int y, int gridx, int gridy);
  bool loadn(game *g, int x, int y, int gridx, int gridy);
  void copy_grid(int to, int from);
+ void index_features(int gridn); // Rebuild grid[gridn].features
+ void build_seen_cache(int x, int y, int range);
+ void build_fov(bool fov[SEEX * MAPSIZE][SEEY * MAPSIZE], int x, int y,
+                int range);
+ std::vector<point> box_route(int Fx, int Fy, int Tx, int Ty, bool bash);
+ std::vector<point> long_route(int Fx, int Fy, int Tx, int Ty, bool bash);
+ void smooth_route(int Fx, int Fy, std::vector<point> &path, bool bash);
+ int route_cost(std::vector<point> &path, int from, int to, bool bash);
+ void check_route_cache(int n);
+ void route_dists(int n, bool bash);
+ bool node_across(int n, int i, int &n2, int &i2);
+ void local_route(int n, int x, int y, bool bash, bool reverse,
+                  int goalx, int goaly);
+ void snapshot_fields(); // Copy the fields into field_prev; see field.cpp
+ void run_field_jobs(game *g, field_jobs *jobs); // Until they're all taken
+ unsigned long field_seed(int x, int y, int z); // For submap (x, y, z) now
+ field prev_field(int x, int y); // The field as process_fields() began
+ void melt_items(field *cur, std::vector<item> &items);
+ void process_fire(game *g, int x, int y, field *cur, std::vector<item> &items,
+                   std::vector<field_change> &changes);
+ void spread_gas(game *g, int x, int y, field *cur,
+                 std::vector<field_change> &changes);
+ void apply_field_changes(game *g);
+ void apply_field_change(game *g, field_change &c);
+ void build_tile_cache();
+ void build_outside_mask(int n);
+ int tile_flags(int x, int y);
+ int calc_tile_cost(int x, int y);
+ int calc_tile_flags(int x, int y);
+ void cast_fov(bool fov[SEEX * MAPSIZE][SEEY * MAPSIZE], int x, int y,
+               int quad, int depth, int range,
+               int start_n, int start_d, int end_n, int end_d);
  void draw_map(oter_id terrain_type, oter_id t_north, oter_id t_east,
                oter_id t_south, oter_id t_west, oter_id t_above, int turn,
                game *g);
@@ -161,6 +329,41 @@ protected:
  field nulfield; // Returned when &field_at() is asked for an OOB value
  vehicle nulveh; // Returned when &veh_at() is asked for an OOB value
  int nulrad;	// OOB &radiation()
+// Last known tile of active items, so find_item() needn't scan the whole map.
+// Entries may go stale when a stack's vector moves; find_item() checks them.
+ std::map<item*, point> item_locs;
+// Field of view used by pl_sees(); seen_range is -1 when it needs rebuilding
+ bool seen_cache[SEEX * MAPSIZE][SEEY * MAPSIZE];
+ int seen_x, seen_y, seen_range;
+// Last generation of fields, read while process_fields() writes the next; only
+//  submaps which had fields (field_snapped) are copied in
+ std::vector<field> field_prev;
+ bool field_snapped[MAPSIZE * MAPSIZE];
+// Squares next to a fire which had something flammable on them, as the fires
+//  will see them this pass; and the changes each submap's fields have queued
+ std::set<int> field_fuel;
+ std::vector<field_change> field_changes[MAPSIZE * MAPSIZE];
+ int field_turn, field_pass; // process_fields() calls during field_turn
+// Field of view from sight_from(); rebuilt on use when sight_valid is false
+ bool sight_cache[SEEX * MAPSIZE][SEEY * MAPSIZE];
+ int sight_x, sight_y, sight_range;
+ bool sight_valid;
+// Packed move_cost(), trans() and bashable/door bits (see tile_bit in map.cpp)
+//  for the whole bubble, so LOS and pathing needn't look up terrain, fields
+//  and vehicles per step.  Rebuilt lazily when tile_cache_valid is false;
+//  touch_tile() patches single squares in place.
+ unsigned char tile_cost[SEEX * MAPSIZE][SEEY * MAPSIZE];
+ unsigned char tile_bits[SEEX * MAPSIZE][SEEY * MAPSIZE];
+ bool tile_cache_valid;
+// is_outside() for each submap, a row of SEEX bits per y; built on first use
+//  after invalidate_cache(), and dropped by touch_tile() for any submap the
+//  changed tile could roof
+ unsigned short outside_mask[MAPSIZE * MAPSIZE][SEEY];
+ bool outside_valid[MAPSIZE * MAPSIZE];
+// Answers sees() has given since transparency last changed; the value is the
+//  t it found, or LOS_BLOCKED
+ std::map<los_key, int> los_memo;
+ route_cache route_caches[MAPSIZE * MAPSIZE];
 
  std::vector <itype*> *itypes;
  std::vector <trap*> *traps;
@@ -671,6 +671,7 @@ struct submap {
  std::vector<spawn_point> spawns;
  std::vector<vehicle> vehicles;
  computer comp;
+ std::vector<point> features; // Stairs, consoles &c; see map::find_terrain()
 };
 
 #endif
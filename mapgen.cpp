@@ -5896,6 +5896,7 @@ vehicle *map::add_vehicle(vhtype_id type, int x, int y, int dir)
 // debugmsg("n=%d x=%d y=%d MAPSIZE=%d ^2=%d", nonant, x, y, MAPSIZE, MAPSIZE*MAPSIZE);
  vehicle veh(type, x, y, dir, 0);
  grid[nonant].vehicles.push_back(veh);
+ invalidate_cache();	// Its parts change move cost and sight
  return &grid[nonant].vehicles[grid[nonant].vehicles.size()-1];
 }
 
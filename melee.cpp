@@ -266,9 +266,10 @@ int player::hit_mon(game *g, monster *z)
    for (int y = z->posy - 1; y <= z->posy + 1; y++) {
     if (!one_in(3)) {
      if (g->m.field_at(x, y).type == fd_blood &&
-         g->m.field_at(x, y).density < 3)
+         g->m.field_at(x, y).density < 3) {
       g->m.field_at(x, y).density++;
-     else
+      g->m.touch_tile(x, y);
+     } else
       g->m.add_field(g, x, y, fd_blood, 1);
     }
    }
@@ -99,9 +99,10 @@ void mattack::acid(game *g, monster *z)
        g->m.sees(hitx + i, hity + j, hitx, hity, 6, junk) &&
        ((one_in(abs(j)) && one_in(abs(i))) || (i == 0 && j == 0))) {
     if (g->m.field_at(hitx + i, hity + j).type == fd_acid &&
-        g->m.field_at(hitx + i, hity + j).density < 3)
+        g->m.field_at(hitx + i, hity + j).density < 3) {
      g->m.field_at(hitx + i, hity + j).density++;
-    else
+     g->m.touch_tile(hitx + i, hity + j);
+    } else
      g->m.add_field(g, hitx + i, hity + j, fd_acid, 2);
    }
   }
@@ -151,10 +152,12 @@ void mattack::boomer(game *g, monster *z)
   if (g->m.field_at(line[i].x, line[i].y).type == fd_blood) {
    g->m.field_at(line[i].x, line[i].y).type = fd_bile;
    g->m.field_at(line[i].x, line[i].y).density = 1;
+   g->m.touch_tile(line[i].x, line[i].y);
   } else if (g->m.field_at(line[i].x, line[i].y).type == fd_bile &&
-             g->m.field_at(line[i].x, line[i].y).density < 3)
+             g->m.field_at(line[i].x, line[i].y).density < 3) {
    g->m.field_at(line[i].x, line[i].y).density++;
-  else
+   g->m.touch_tile(line[i].x, line[i].y);
+  } else
    g->m.add_field(g, line[i].x, line[i].y, fd_bile, 1);
 // If bile hit a solid tile, return.
   if (g->m.move_cost(line[i].x, line[i].y) == 0) {
@@ -318,9 +321,9 @@ void mattack::growplants(game *g, monster *z)
    if (i == 0 && j == 0)
     j++;
    if (!g->m.has_flag(diggable, z->posx + i, z->posy + j) && one_in(4))
-    g->m.ter(z->posx + i, z->posy + j) = t_dirt;
+    g->m.ter_set(z->posx + i, z->posy + j, t_dirt);
    else if (one_in(3) && g->m.is_destructable(z->posx + i, z->posy + j))
-    g->m.ter(z->posx + i, z->posy + j) = t_dirtmound; // Destroy walls, &c
+    g->m.ter_set(z->posx + i, z->posy + j, t_dirtmound); // Destroy walls, &c
    else {
     if (one_in(4)) {	// 1 in 4 chance to grow a tree
      int mondex = g->mon_at(z->posx + i, z->posy + j);
@@ -361,57 +364,56 @@ void mattack::growplants(game *g, monster *z)
        g->active_npc[npcdex].hit(g, hit, side, 0, rng(10, 30));
       }
      }
-     g->m.ter(z->posx + i, z->posy + j) = t_tree_young;
+     g->m.ter_set(z->posx + i, z->posy + j, t_tree_young);
     } else if (one_in(3)) // If no tree, perhaps underbrush
-     g->m.ter(z->posx + i, z->posy + j) = t_underbrush;
+     g->m.ter_set(z->posx + i, z->posy + j, t_underbrush);
    }
   }
  }
 
  if (one_in(5)) { // 1 in 5 chance of making exisiting vegetation grow larger
-  for (int i = -5; i <= 5; i++) {
-   for (int j = -5; j <= 5; j++) {
-    if (i != 0 || j != 0) {
-     if (g->m.ter(z->posx + i, z->posy + j) == t_tree_young)
-      g->m.ter(z->posx + i, z->posy + j) = t_tree; // Young tree => tree
-     else if (g->m.ter(z->posx + i, z->posy + j) == t_underbrush) {
+  for (map_iterator it = g->m.radius(z->posx, z->posy, 5); !it.done();
+       it.next()) {
+   if (it.x != z->posx || it.y != z->posy) {
+    if (it.ter() == t_tree_young)
+     g->m.ter_set(it.x, it.y, t_tree); // Young tree => tree
+    else if (it.ter() == t_underbrush) {
 // Underbrush => young tree
-      int mondex = g->mon_at(z->posx + i, z->posy + j);
-      if (mondex != -1) {
-       if (g->u_see(z->posx + i, z->posy + j, junk))
-        g->add_msg("Underbrush forms into a tree, and it pierces the %s!",
-                   g->z[mondex].name().c_str());
-       int rn = rng(10, 30);
-       rn -= g->z[mondex].armor_cut();
-       if (rn < 0)
-        rn = 0;
-       if (g->z[mondex].hurt(rn))
-        g->kill_mon(mondex);
-      } else if (g->u.posx == z->posx + i && g->u.posy == z->posy + j) {
+     int mondex = g->mon_at(it.x, it.y);
+     if (mondex != -1) {
+      if (g->u_see(it.x, it.y, junk))
+       g->add_msg("Underbrush forms into a tree, and it pierces the %s!",
+                  g->z[mondex].name().c_str());
+      int rn = rng(10, 30);
+      rn -= g->z[mondex].armor_cut();
+      if (rn < 0)
+       rn = 0;
+      if (g->z[mondex].hurt(rn))
+       g->kill_mon(mondex);
+     } else if (g->u.posx == it.x && g->u.posy == it.y) {
+      body_part hit = bp_legs;
+      int side = rng(1, 2);
+      if (one_in(4))
+       hit = bp_torso;
+      else if (one_in(2))
+       hit = bp_feet;
+      g->add_msg("The underbrush beneath your feet grows and pierces your %s!",
+                 body_part_name(hit, side).c_str());
+      g->u.hit(g, hit, side, 0, rng(10, 30));
+     } else {
+      int npcdex = g->npc_at(it.x, it.y);
+      if (npcdex != -1) {
        body_part hit = bp_legs;
        int side = rng(1, 2);
        if (one_in(4))
         hit = bp_torso;
        else if (one_in(2))
         hit = bp_feet;
-       g->add_msg("The underbrush beneath your feet grows and pierces your %s!",
-                  body_part_name(hit, side).c_str());
-       g->u.hit(g, hit, side, 0, rng(10, 30));
-      } else {
-       int npcdex = g->npc_at(z->posx + i, z->posy + j);
-       if (npcdex != -1) {
-        body_part hit = bp_legs;
-        int side = rng(1, 2);
-        if (one_in(4))
-         hit = bp_torso;
-        else if (one_in(2))
-         hit = bp_feet;
-        if (g->u_see(z->posx + i, z->posy + j, junk))
-         g->add_msg("Underbrush grows into a tree, and it pierces %s's %s!",
-                    g->active_npc[npcdex].name.c_str(),
-                    body_part_name(hit, side).c_str());
-        g->active_npc[npcdex].hit(g, hit, side, 0, rng(10, 30));
-       }
+       if (g->u_see(it.x, it.y, junk))
+        g->add_msg("Underbrush grows into a tree, and it pierces %s's %s!",
+                   g->active_npc[npcdex].name.c_str(),
+                   body_part_name(hit, side).c_str());
+       g->active_npc[npcdex].hit(g, hit, side, 0, rng(10, 30));
       }
      }
     }
@@ -552,9 +554,9 @@ void mattack::triffid_heartbeat(game *g, monster *z)
   for (int x = g->u.posx; x <= z->posx - 3; x++) {
    for (int y = g->u.posy; y <= z->posy - 3; y++) {
     if (g->is_empty(x, y) && one_in(4))
-     g->m.ter(x, y) = t_root_wall;
+     g->m.ter_set(x, y, t_root_wall);
     else if (g->m.ter(x, y) == t_root_wall && one_in(10))
-     g->m.ter(x, y) = t_dirt;
+     g->m.ter_set(x, y, t_dirt);
    }
   }
 // Open blank tiles as long as there's no possible route
@@ -563,7 +565,7 @@ void mattack::triffid_heartbeat(game *g, monster *z)
          tries < 20) {
    int x = rng(g->u.posx, z->posx - 3), y = rng(g->u.posy, z->posy - 3);
    tries++;
-   g->m.ter(x, y) = t_dirt;
+   g->m.ter_set(x, y, t_dirt);
    if (rl_dist(x, y, g->u.posx, g->u.posy > 3 && g->z.size() < 30 &&
        g->mon_at(x, y) == -1 && one_in(20))) { // Spawn an extra monster
     mon_id montype = mon_triffid;
@@ -1071,7 +1073,7 @@ void mattack::stare(game *g, monster *z)
        g->m.ter(sight[i].x, sight[i].y) == t_reinforced_glass_v)
     i = sight.size();
    else if (g->m.is_destructable(sight[i].x, sight[i].y))
-    g->m.ter(sight[i].x, sight[i].y) = t_rubble;
+    g->m.ter_set(sight[i].x, sight[i].y, t_rubble);
   }
  }
 }
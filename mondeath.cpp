@@ -12,9 +12,10 @@ void mdeath::normal(game *g, monster *z)
   g->add_msg("It dies!");
  if (z->made_of(FLESH) && z->has_flag(MF_WARM)) {
   if (g->m.field_at(z->posx, z->posy).type == fd_blood &&
-      g->m.field_at(z->posx, z->posy).density < 3)
+      g->m.field_at(z->posx, z->posy).density < 3) {
    g->m.field_at(z->posx, z->posy).density++;
-  else
+   g->m.touch_tile(z->posx, z->posy);
+  } else
    g->m.add_field(g, z->posx, z->posy, fd_blood, 1);
  }
 // Drop a dang ol' corpse
@@ -43,9 +44,10 @@ void mdeath::boomer(game *g, monster *z)
   for (int j = -1; j <= 1; j++) {
    g->m.bash(z->posx + i, z->posy + j, 10, tmp);
    if (g->m.field_at(z->posx + i, z->posy + j).type == fd_bile &&
-       g->m.field_at(z->posx + i, z->posy + j).density < 3)
+       g->m.field_at(z->posx + i, z->posy + j).density < 3) {
     g->m.field_at(z->posx + i, z->posy + j).density++;
-   else
+    g->m.touch_tile(z->posx + i, z->posy + j);
+   } else
     g->m.add_field(g, z->posx + i, z->posy + j, fd_bile, 1);
    int mondex = g->mon_at(z->posx + i, z->posy +j);
    if (mondex != -1) {
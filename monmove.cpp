@@ -29,6 +29,41 @@ void monster::receive_moves()
  moves += speed;
 }
 
+// Anything plan() would go after keeps us active, checked with the same sight
+// tests plan() uses; nobody further off than we can see needs a sight test
+monster_activity monster::activity(game *g, std::vector<int> &friends)
+{
+ if (friendly != 0 || !plans.empty() || !effects.empty() ||
+     !g->m.field_at(posx, posy).is_null())
+  return MA_ACTIVE;
+ int light = g->light_level(), t;
+ bool sight = can_see();
+ int dist = rl_dist(posx, posy, g->u.posx, g->u.posy);
+ if (dist <= MON_AWAKE_RANGE ||
+     (sight && dist <= light && g->sees_u(posx, posy, t)))
+  return MA_ACTIVE;
+ for (int i = 0; i < g->active_npc.size(); i++) {
+  npc *me = &(g->active_npc[i]);
+  dist = rl_dist(posx, posy, me->posx, me->posy);
+  if (dist <= MON_AWAKE_RANGE ||
+      (sight && dist <= light &&
+       g->m.sees(posx, posy, me->posx, me->posy, light, t)))
+   return MA_ACTIVE;
+ }
+ for (int i = 0; i < friends.size(); i++) {
+  monster *mon = &(g->z[friends[i]]);
+  dist = rl_dist(posx, posy, mon->posx, mon->posy);
+  if (mon->friendly != 0 &&
+      (dist <= MON_AWAKE_RANGE ||
+       (sight && dist <= light &&
+        g->m.sees(posx, posy, mon->posx, mon->posy, light, t))))
+   return MA_ACTIVE;
+ }
+ if (wandf > 0 || (has_flag(MF_SMELLS) && g->scent(posx, posy) > 0))
+  return MA_ALERT;
+ return MA_DORMANT;
+}
+
 bool monster::wander()
 {
  return (plans.empty());
@@ -70,26 +105,34 @@ void monster::wander_to(int x, int y, int f)
   wandf *= 6;
 }
 
-void monster::plan(game *g)
+void monster::plan(game *g, std::vector<int> &friends)
 {
  int sightrange = g->light_level();
  int closest = -1;
  int dist = 1000;
  int tc, stc;
  if (friendly != 0) {	// Target monsters, not the player!
+// Cast our view once, rather than a line to each monster; only the one we
+// pick needs a real line to follow
+  g->m.sight_from(posx, posy, sightrange);
   for (int i = 0; i < g->z.size(); i++) {
    monster *tmp = &(g->z[i]);
    if (tmp->friendly == 0 && rl_dist(posx, posy, tmp->posx, tmp->posy) < dist &&
-       g->m.sees(posx, posy, tmp->posx, tmp->posy, sightrange, tc)) {
+       g->m.in_sight(tmp->posx, tmp->posy)) {
     closest = i;
     dist = rl_dist(posx, posy, tmp->posx, tmp->posy);
-    stc = tc;
    }
   }
   if (has_effect(ME_DOCILE))
    closest = -1;
-  if (closest >= 0)
-   set_dest(g->z[closest].posx, g->z[closest].posy, stc);
+  if (closest >= 0) {
+   monster *target = &(g->z[closest]);
+   if (g->m.sees(posx, posy, target->posx, target->posy, sightrange, stc))
+    set_dest(target->posx, target->posy, stc);
+   else	// The cast saw it, but no straight line gets there; walk around
+    plans = g->m.route(posx, posy, target->posx, target->posy,
+                       has_flag(MF_BASHES));
+  }
   else if (friendly > 0 && one_in(3))	// Grow restless with no targets
    friendly--;
   else if (friendly < 0 && g->sees_u(posx, posy, tc)) {
@@ -122,7 +165,8 @@ void monster::plan(game *g)
     stc = tc;
    }
   }
-  for (int i = 0; i < g->z.size(); i++) {
+  for (int n = 0; n < friends.size(); n++) {
+   int i = friends[n];
    monster *mon = &(g->z[i]);
    if (mon->friendly != 0 && rl_dist(posx, posy, mon->posx, mon->posy) < dist &&
        g->m.sees(posx, posy, mon->posx, mon->posy, sightrange, tc)) {
@@ -143,7 +187,7 @@ void monster::plan(game *g)
 // General movement.
 // Currently, priority goes:
 // 1) Special Attack
-// 2) Sight-based tracking
+// 2) Sight-based tracking, around obstacles via the pursuit map
 // 3) Scent-based tracking
 // 4) Sound-based tracking
 void monster::move(game *g)
@@ -202,7 +246,17 @@ void monster::move(game *g)
   // CONCRETE PLANS - Most likely based on sight
   next = plans[0];
   moved = true;
- } else if (has_flag(MF_SMELLS)) {
+ } else if (plans.size() > 0 && plans.back().x == g->u.posx &&
+            plans.back().y == g->u.posy) {
+// We can see the player, but the straight line is blocked; take the shortest
+//  walking route instead
+  point tmp = pursuit_move(g);
+  if (tmp.x != -1) {
+   next = tmp;
+   moved = true;
+  }
+ }
+ if (!moved && has_flag(MF_SMELLS)) {
 // No sight... or our plans are invalid (e.g. moving through a transparent, but
 //  solid, square of terrain).  Fall back to smell if we have it.
   point tmp = scent_move(g);
@@ -359,6 +413,36 @@ point monster::scent_move(game *g)
  return next;
 }
 
+// Step downhill on the game's shared distance-to-player map
+point monster::pursuit_move(game *g)
+{
+ std::vector<point> pmoves;
+ int here = g->pursuit_dist(posx, posy), best = here;
+ point next(-1, -1);
+ for (int x = -1; x <= 1; x++) {
+  for (int y = -1; y <= 1; y++) {
+   int dist = g->pursuit_dist(posx + x, posy + y);
+   if (dist > best || dist >= here)
+    continue;
+   if ((g->mon_at(posx + x, posy + y) == -1 || has_flag(MF_ATTACKMON)) &&
+       (can_move_to(g->m, posx + x, posy + y) ||
+        (posx + x == g->u.posx && posy + y == g->u.posy) ||
+        (g->m.has_flag(bashable, posx + x, posy + y) && has_flag(MF_BASHES)))) {
+    if (dist < best) {
+     pmoves.clear();
+     best = dist;
+    }
+    pmoves.push_back(point(posx + x, posy + y));
+   }
+  }
+ }
+ if (pmoves.size() > 0) {
+  plans.clear();
+  next = pmoves[rng(0, pmoves.size() - 1)];
+ }
+ return next;
+}
+
 point monster::sound_move(game *g)
 {
  plans.clear();
@@ -520,7 +604,7 @@ void monster::move_to(game *g, int x, int y)
   }
 // Diggers turn the dirt into dirtmound
   if (has_flag(MF_DIGS))
-   g->m.ter(posx, posy) = t_dirtmound;
+   g->m.ter_set(posx, posy, t_dirtmound);
 // Acid trail monsters leave... a trail of acid
   if (has_flag(MF_ACIDTRAIL))
    g->m.add_field(g, posx, posy, fd_acid, 1);
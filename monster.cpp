@@ -24,6 +24,8 @@ monster::monster()
  wandx = -1;
  wandy = -1;
  wandf = 0;
+ dormant_turns = 0;
+ turn_stamp = 0;
  hp = 60;
  moves = 0;
  sp_timeout = 0;
@@ -46,6 +48,8 @@ monster::monster(mtype *t)
  wandx = -1;
  wandy = -1;
  wandf = 0;
+ dormant_turns = 0;
+ turn_stamp = 0;
  type = t;
  moves = type->speed;
  speed = type->speed;
@@ -70,6 +74,8 @@ monster::monster(mtype *t, int x, int y)
  wandx = -1;
  wandy = -1;
  wandf = 0;
+ dormant_turns = 0;
+ turn_stamp = 0;
  type = t;
  moves = type->speed;
  speed = type->speed;
@@ -25,6 +25,13 @@ ME_HIT_BY_PLAYER,	// We shot or hit them
 NUM_MONSTER_EFFECTS
 };
 
+// How much attention game::monmove() pays a monster this turn
+enum monster_activity {
+ MA_ACTIVE,	// Near the player or busy; full planning every turn
+ MA_ALERT,	// Following a sound or a scent; full planning every turn
+ MA_DORMANT	// Nothing to react to; only acts every MON_DORMANT_TURNS
+};
+
 struct monster_effect
 {
  monster_effect_type type;
@@ -70,16 +77,18 @@ class monster {
 				      // t determines WHICH Bresenham line
  void wander_to(int x, int y, int f); // Try to get to (x, y), we don't know
 				      // the route.  Give up after f steps.
- void plan(game *g);
+ void plan(game *g, std::vector<int> &friends); // friends: see monmove()
  void move(game *g); // Actual movement
  void footsteps(game *g, int x, int y); // noise made by movement
  void friendly_move(game *g);
 
  point scent_move(game *g);
+ point pursuit_move(game *g);
  point sound_move(game *g);
  void hit_player(game *g, player &p);
  void move_to(game *g, int x, int y);
  void stumble(game *g, bool moved);
+ monster_activity activity(game *g, std::vector<int> &friends);
 
 // Combat
  bool is_fleeing(player &u);	// True if we're fleeing
@@ -106,6 +115,8 @@ class monster {
  int posx, posy;
  int wandx, wandy; // Wander destination - Just try to move in that direction
  int wandf;	   // Urge to wander - Increased by sound, decrements each move
+ int dormant_turns; // Turns skipped since we last acted while dormant
+ int turn_stamp;    // Who we are in game::monmove()'s queue; see there
  std::vector<item> inv; // Inventory
  std::vector<monster_effect> effects; // Active effects, e.g. on fire
 
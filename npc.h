@@ -13,6 +13,11 @@
 #define NPC_VERY_HI_VALUE  15
 #define NPC_DANGER_LEVEL   10
 #define NPC_DANGER_VERY_LOW 5
+// update_path() extends our old path if the target moved at most this far
+// from its end, and keeps a repaired path no longer than twice the distance
+// to the target plus this; anything worse is searched again from scratch
+#define NPC_PATH_REPAIR     2
+#define NPC_PATH_SLACK      6
 
 class item;
 class overmap;
@@ -367,6 +372,7 @@ public:
 
 // Physical movement from one tile to the next
  void update_path	(game *g, int x, int y);
+ bool repair_path	(game *g, int x, int y); // False if it can't be saved
  bool can_move_to	(game *g, int x, int y);
  void move_to		(game *g, int x, int y);
  void move_to_next	(game *g); // Next in <path>
@@ -414,7 +420,7 @@ public:
  int mapx, mapy;// Which square in that overmap (e.g., m.0.0)
  int plx, ply, plt;// Where we last saw the player, timeout to forgetting
  int itx, ity;	// The square containing an item we want
- int goalx, goaly;// Which mapx:mapy square we want to get to
+ int goalx, goaly;// Which overmap tile (mapx / 2, mapy / 2) we want to reach
 
  bool fetching_item;
  int  worst_item_value; // The value of our least-wanted item
@@ -808,14 +808,67 @@ void npc::update_path(game *g, int x, int y)
   path = g->m.route(posx, posy, x, y);
   return;
  }
- point last = path[path.size() - 1];
- if (last.x == x && last.y == y)
-  return; // Our path already leads to that point, no need to recalculate
+ if (repair_path(g, x, y))
+  return; // Our old path, patched up, still leads to that point
  path = g->m.route(posx, posy, x, y);
- if (path[0].x == posx && path[0].y == posy)
+ if (!path.empty() && path[0].x == posx && path[0].y == posy)
   path.erase(path.begin());
 }
 
+// Rather than searching again every time our target steps away, patch the
+// path we already have: squares which have become impassable are walked
+// around, and a target which only moved a little is reached from the end of
+// the old path.  Both only search the few squares involved.
+bool npc::repair_path(game *g, int x, int y)
+{
+ if (rl_dist(posx, posy, path[0].x, path[0].y) != 1)
+  return false;	// We've been moved off of it
+ for (int i = 0; i < path.size(); i++) {
+  if (i > 0 &&
+      rl_dist(path[i - 1].x, path[i - 1].y, path[i].x, path[i].y) != 1)
+   return false;
+  if (g->m.move_cost(path[i].x, path[i].y) > 0 ||
+      g->m.has_flag(bashable, path[i].x, path[i].y))
+   continue;
+// path[i] is blocked now; find a way from the square before it to the first
+// open square after it
+  int j = i + 1;
+  while (j < path.size() && g->m.move_cost(path[j].x, path[j].y) == 0 &&
+         !g->m.has_flag(bashable, path[j].x, path[j].y))
+   j++;
+  if (j == path.size()) {
+   path.erase(path.begin() + i, path.end());
+   break;	// The end is blocked off; try to reach the target from here
+  }
+  point from = (i == 0 ? point(posx, posy) : path[i - 1]);
+  std::vector<point> detour = g->m.route(from.x, from.y, path[j].x, path[j].y);
+  if (detour.empty() || detour.size() > j - i + 1 + NPC_PATH_SLACK)
+   return false;
+  path.erase(path.begin() + i, path.begin() + j + 1);
+  path.insert(path.begin() + i, detour.begin(), detour.end());
+  i += detour.size() - 1;
+ }
+ if (path.empty())
+  return false;
+// If the target stepped back onto our path, stop there
+ int end = path.size() - 1;
+ for (int i = end; i >= 0 && i >= end - NPC_PATH_REPAIR; i--) {
+  if (path[i].x == x && path[i].y == y) {
+   path.erase(path.begin() + i + 1, path.end());
+   return true;
+  }
+ }
+ point last = path[end];
+ if (rl_dist(last.x, last.y, x, y) > NPC_PATH_REPAIR)
+  return false;
+ std::vector<point> extra = g->m.route(last.x, last.y, x, y);
+ if (extra.empty())
+  return false;
+ path.insert(path.end(), extra.begin(), extra.end());
+// Chasing a target around adds up to a crooked path; start over if it has
+ return (path.size() <= rl_dist(posx, posy, x, y) * 2 + NPC_PATH_SLACK);
+}
+
 bool npc::can_move_to(game *g, int x, int y)
 {
  if ((g->m.move_cost(x, y) > 0 || g->m.has_flag(bashable, x, y)) &&
@@ -1051,34 +1104,24 @@ void npc::find_item(game *g)
  int range = sight_range(g->light_level());
  if (range > 12)
   range = 12;
- int minx = posx - range, maxx = posx + range,
-     miny = posy - range, maxy = posy + range;
- int index = -1, linet;
- if (minx < 0)
-  minx = 0;
- if (miny < 0)
-  miny = 0;
- if (maxx >= SEEX * MAPSIZE)
-  maxx = SEEX * MAPSIZE - 1;
- if (maxy >= SEEY * MAPSIZE)
-  maxy = SEEY * MAPSIZE - 1;
-
- for (int x = minx; x <= maxx; x++) {
-  for (int y = miny; y <= maxy; y++) {
-   if (g->m.sees(posx, posy, x, y, range, linet)) {
-    for (int i = 0; i < g->m.i_at(x, y).size(); i++) {
-     int itval = value(g->m.i_at(x, y)[i]);
-     int wgt = g->m.i_at(x, y)[i].weight(), vol = g->m.i_at(x, y)[i].volume();
-     if (itval > best_value &&
-         //(itval > worst_item_value ||
-          (weight_carried() + wgt <= weight_capacity() / 4 &&
-           volume_carried() + vol <= volume_capacity()       )) {
-      itx = x;
-      ity = y;
-      index = i;
-      best_value = itval;
-      fetching_item = true;
-     }
+ int index = -1;
+
+ g->m.sight_from(posx, posy, range);
+ for (map_iterator it = g->m.radius(posx, posy, range); !it.done(); it.next()) {
+  std::vector<item> &here = it.items();
+  if (!here.empty() && g->m.in_sight(it.x, it.y)) {
+   for (int i = 0; i < here.size(); i++) {
+    int itval = value(here[i]);
+    int wgt = here[i].weight(), vol = here[i].volume();
+    if (itval > best_value &&
+        //(itval > worst_item_value ||
+         (weight_carried() + wgt <= weight_capacity() / 4 &&
+          volume_carried() + vol <= volume_capacity()       )) {
+     itx = it.x;
+     ity = it.y;
+     index = i;
+     best_value = itval;
+     fetching_item = true;
     }
    }
   }
@@ -1826,21 +1869,27 @@ void npc::set_destination(game *g)
  oter_id dest_type = options[rng(0, options.size() - 1)];
 
  int dist = 0;
- point p = g->cur_om.find_closest(point(mapx, mapy),dest_type,4, dist, false);
+ point p = g->cur_om.find_closest(point(mapx / 2, mapy / 2), dest_type, 4,
+                                  dist, false);
  goalx = p.x;
  goaly = p.y;
 }
 
+// goalx, goaly are overmap tiles, each two of our mapx, mapy squares across.
 void npc::go_to_destination(game *g)
 {
- int sx = (goalx > mapx ? 1 : -1), sy = (goaly > mapy ? 1 : -1);
- if (goalx == mapx && goaly == mapy)	// We're at our desired map square!
+ int tilex = mapx / 2, tiley = mapy / 2;
+ if (goalx == tilex && goaly == tiley)	// We're at our desired map square!
   move_pause();
  else {
-  if (goalx == mapx)
-   sx = 0;
-  if (goaly == mapy)
-   sy = 0;
+// Head for the next tile along the overmap route, or straight at the goal if
+// there's no known way there
+  point next(goalx, goaly);
+  std::vector<point> om_path = g->om_route(point(tilex, tiley), next);
+  if (!om_path.empty())
+   next = om_path[0];
+  int sx = (next.x > tilex ? 1 : (next.x < tilex ? -1 : 0)),
+      sy = (next.y > tiley ? 1 : (next.y < tiley ? -1 : 0));
 // sx and sy are now equal to the direction we need to move in
   int x = posx + 8 * sx, y = posy + 8 * sy, linet, light = g->light_level();
 // x and y are now equal to a local square that's close by
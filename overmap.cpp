@@ -10,6 +10,7 @@
 #include <fstream>
 #include <vector>
 #include <sstream>
+#include <algorithm>
 #include "overmap.h"
 #include "rng.h"
 #include "line.h"
@@ -123,6 +124,8 @@ overmap::overmap()
  posx = 999;
  posy = 999;
  posz = 999;
+ zg_indexed = -1;
+ oter_indexed = false;
  if (num_ter_types > 256)
   debugmsg("More than 256 oterid!  Saving won't work!");
 }
@@ -132,6 +135,8 @@ overmap::overmap(game *g, int x, int y, int z)
  if (num_ter_types > 256)
   debugmsg("More than 256 oterid!  Saving won't work!");
  nullret = ot_null;
+ zg_indexed = -1;
+ oter_indexed = false;
  open(g, x, y, z);
 }
 
@@ -153,13 +158,62 @@ std::vector<mongroup*> overmap::monsters_at(int x, int y)
  std::vector<mongroup*> ret;
  if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY)
   return ret;
- for (int i = 0; i < zg.size(); i++) {
-  if (trig_dist(x, y, zg[i].posx, zg[i].posy) <= zg[i].radius)
-   ret.push_back(&(zg[i]));
+ std::vector<int> nearby = mongroups_near(x, y);
+ for (int i = 0; i < nearby.size(); i++) {
+  if (trig_dist(x, y, zg[nearby[i]].posx, zg[nearby[i]].posy) <= zg[nearby[i]].radius)
+   ret.push_back(&(zg[nearby[i]]));
  }
  return ret;
 }
 
+int mongroup_bucket(int n)
+{
+ n /= MONGROUP_BUCKET;
+ if (n < 0)
+  return 0;
+ if (n >= MONGROUP_BUCKETS)
+  return MONGROUP_BUCKETS - 1;
+ return n;
+}
+
+std::vector<int> overmap::mongroups_near(int x, int y, int pad)
+{
+ std::vector<int> ret;
+ if (zg_indexed != zg.size())
+  index_mongroups();
+ int range = zg_max_radius + pad;
+ int maxx = mongroup_bucket(x + range), maxy = mongroup_bucket(y + range);
+ for (int bx = mongroup_bucket(x - range); bx <= maxx; bx++) {
+  for (int by = mongroup_bucket(y - range); by <= maxy; by++)
+   ret.insert(ret.end(), zg_buckets[bx][by].begin(), zg_buckets[bx][by].end());
+ }
+ std::sort(ret.begin(), ret.end());
+ return ret;
+}
+
+void overmap::index_mongroups()
+{
+ for (int x = 0; x < MONGROUP_BUCKETS; x++) {
+  for (int y = 0; y < MONGROUP_BUCKETS; y++)
+   zg_buckets[x][y].clear();
+ }
+ zg_max_radius = 0;
+ for (int i = 0; i < zg.size(); i++) {
+  int bx = mongroup_bucket(zg[i].posx), by = mongroup_bucket(zg[i].posy);
+  zg_buckets[bx][by].push_back(i);
+  if (zg[i].radius > zg_max_radius)
+   zg_max_radius = zg[i].radius;
+ }
+ zg_indexed = zg.size();
+}
+
+void overmap::grow_mongroup(int i)
+{
+ zg[i].radius++;
+ if (zg[i].radius > zg_max_radius)
+  zg_max_radius = zg[i].radius;
+}
+
 bool& overmap::seen(int x, int y)
 {
  if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY) {
@@ -674,22 +728,71 @@ void overmap::make_tutorial()
  }
  ter(50, 50) = ot_tutorial;
  zg.clear();
+ oter_indexed = false;
+}
+
+bool point_before(const point &a, const point &b)
+{
+ return (a.x < b.x || (a.x == b.x && a.y < b.y));
+}
+
+void overmap::index_terrain()
+{
+ for (int i = 0; i < num_ter_types; i++)
+  oter_locs[i].clear();
+ for (int x = 0; x < OMAPX; x++) {
+  for (int y = 0; y < OMAPY; y++) {
+   if (t[x][y] >= 0 && t[x][y] < num_ter_types)
+    oter_locs[t[x][y]].push_back(point(x, y));
+  }
+ }
+ oter_indexed = true;
+}
+
+void overmap::oter_set(int x, int y, oter_id type)
+{
+ if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY)
+  return;
+ oter_id old = t[x][y];
+ t[x][y] = type;
+ if (!oter_indexed || old == type)
+  return;
+ point p(x, y);
+ if (old >= 0 && old < num_ter_types) {
+  std::vector<point> &locs = oter_locs[old];
+  std::vector<point>::iterator it =
+   std::lower_bound(locs.begin(), locs.end(), p, point_before);
+  if (it != locs.end() && it->x == x && it->y == y)
+   locs.erase(it);
+ }
+ if (type >= 0 && type < num_ter_types) {
+  std::vector<point> &locs = oter_locs[type];
+  locs.insert(std::lower_bound(locs.begin(), locs.end(), p, point_before), p);
+ }
 }
 
 point overmap::find_closest(point origin, oter_id type, int type_range,
                             int &dist, bool must_be_seen)
 {
  int max = (dist == 0 ? OMAPX / 2 : dist);
- for (dist = 0; dist <= max; dist++) {
-  for (int x = origin.x - dist; x <= origin.x + dist; x++) {
-   for (int y = origin.y - dist; y <= origin.y + dist; y++) {
-    if (ter(x, y) >= type && ter(x, y) < type + type_range &&
-        (!must_be_seen || seen(x, y)))
-     return point(x, y);
+ if (!oter_indexed)
+  index_terrain();
+ point ret(-1, -1);
+// Closest by rl_dist; ties go to the lowest x, then the lowest y
+ dist = max + 1;
+ for (int i = type; i < type + type_range && i < num_ter_types; i++) {
+  for (int n = 0; n < oter_locs[i].size(); n++) {
+   point p = oter_locs[i][n];
+   int d = rl_dist(origin.x, origin.y, p.x, p.y);
+   if (d > dist || (d == dist && (p.x > ret.x || (p.x == ret.x && p.y > ret.y))))
+    continue;
+   if (ter(p.x, p.y) == i && (!must_be_seen || seen(p.x, p.y))) {
+    ret = p;
+    dist = d;
    }
   }
  }
- return point(-1, -1);
+ return ret;
 }
 
 std::vector<point> overmap::find_all(point origin, oter_id type, int type_range,
@@ -697,27 +800,42 @@ std::vector<point> overmap::find_all(point origin, oter_id type, int type_range,
 {
  std::vector<point> res;
  int max = (dist == 0 ? OMAPX / 2 : dist);
- for (dist = 0; dist <= max; dist++) {
-  for (int x = origin.x - dist; x <= origin.x + dist; x++) {
-   for (int y = origin.y - dist; y <= origin.y + dist; y++) {
-    if (ter(x, y) >= type && ter(x, y) < type + type_range &&
-        (!must_be_seen || seen(x, y)))
-     res.push_back(point(x, y));
-   }
-  }
- }
+ if (!oter_indexed)
+  index_terrain();
+// Bucket by distance, then each bucket is sorted by x and y as in the index
+ std::vector< std::vector<point> > rings(max + 1);
+ for (int i = type; i < type + type_range && i < num_ter_types; i++) {
+  for (int n = 0; n < oter_locs[i].size(); n++) {
+   point p = oter_locs[i][n];
+   int d = rl_dist(origin.x, origin.y, p.x, p.y);
+   if (d <= max && ter(p.x, p.y) == i && (!must_be_seen || seen(p.x, p.y)))
+    rings[d].push_back(p);
+  }
+ }
+ for (int d = 0; d <= max; d++) {
+  if (type_range > 1)
+   std::sort(rings[d].begin(), rings[d].end(), point_before);
+  res.insert(res.end(), rings[d].begin(), rings[d].end());
+ }
+ dist = max + 1;
  return res;
 }
 
 std::vector<point> overmap::find_terrain(std::string term, int cursx, int cursy)
 {
  std::vector<point> found;
- for (int x = 0; x < OMAPX; x++) {
-  for (int y = 0; y < OMAPY; y++) {
-   if (seen(x, y) && oterlist[ter(x, y)].name.find(term) != std::string::npos)
-    found.push_back( point(x, y) );
-  }
- }
+ if (!oter_indexed)
+  index_terrain();
+ for (int i = 0; i < num_ter_types; i++) {
+  if (oterlist[i].name.find(term) == std::string::npos)
+   continue;
+  for (int n = 0; n < oter_locs[i].size(); n++) {
+   point p = oter_locs[i][n];
+   if (seen(p.x, p.y) && ter(p.x, p.y) == i)
+    found.push_back(p);
+  }
+ }
+ std::sort(found.begin(), found.end(), point_before);
  return found;
 }
 
@@ -1117,6 +1235,7 @@ void overmap::process_mongroups()
    zg[i].radius *= .9;
   }
  }
+ index_mongroups();	// Radii may have shrunk
 }
   
 void overmap::place_forest()
@@ -2314,6 +2433,7 @@ void overmap::open(game *g, int x, int y, int z)
  posx = x;
  posy = y;
  posz = z;
+ oter_indexed = false;
  fin.open(terfilename.str().c_str());
 // DEBUG VARS
  int nummg = 0;
@@ -18,6 +18,10 @@
 class npc;
 struct settlement;
 
+// zg is bucketed into squares of this size, in its own (submap) coordinates
+#define MONGROUP_BUCKET 16
+#define MONGROUP_BUCKETS (OMAPX * 2 / MONGROUP_BUCKET + 1)
+
 struct city {
  int x;
  int y;
@@ -80,7 +84,15 @@ class overmap
   point choose_point(game *g);
 
   oter_id& ter(int x, int y);
+// Use this rather than writing ter() once the map is built; it keeps the
+//  find_closest() index current
+  void oter_set(int x, int y, oter_id type);
   std::vector<mongroup*> monsters_at(int x, int y);
+// Indices into zg of the groups which might reach (x, y) with their radius
+//  plus pad, in ascending order.  Callers must still check the distance.
+  std::vector<int> mongroups_near(int x, int y, int pad = 0);
+  void index_mongroups();    // Call after erasing from or adding to zg
+  void grow_mongroup(int i); // zg[i].radius++, keeping the index valid
   bool&   seen(int x, int y);
 
   bool has_note(int x, int y);
@@ -104,6 +116,14 @@ class overmap
   bool s[OMAPX][OMAPY];
   bool nullbool;
   std::vector<om_note> notes;
+  std::vector<int> zg_buckets[MONGROUP_BUCKETS][MONGROUP_BUCKETS];
+// Where each oter_id lies, sorted by x then y; built on first use by
+//  index_terrain(), and kept current by oter_set()
+  std::vector<point> oter_locs[num_ter_types];
+  bool oter_indexed;
+  void index_terrain();
+  int zg_indexed;	// zg.size() when zg_buckets were built; -1 if never
+  int zg_max_radius;
   //Drawing
   void draw(WINDOW *w, game *g, int &cursx, int &cursy, 
                    int &origx, int &origy, char &ch, bool blink);
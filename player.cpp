@@ -2557,8 +2557,10 @@ void player::suffer(game *g)
   if (g->m.field_at(posx, posy).type == fd_null)
    g->m.add_field(g, posx, posy, fd_slime, 1);
   else if (g->m.field_at(posx, posy).type == fd_slime &&
-           g->m.field_at(posx, posy).density < 3)
+           g->m.field_at(posx, posy).density < 3) {
    g->m.field_at(posx, posy).density++;
+   g->m.touch_tile(posx, posy);
+  }
  }
 
  if (has_trait(PF_ACID_TRAIL) && has_trait(PF_SLIMY)) {
@@ -2566,21 +2568,27 @@ void player::suffer(game *g)
     if (one_in(5))
    g->m.add_field(g, posx, posy, fd_acid, 1);
   else if (g->m.field_at(posx, posy).type == fd_acid && one_in(5) &&
-           g->m.field_at(posx, posy).density < 3)
+           g->m.field_at(posx, posy).density < 3) {
    g->m.field_at(posx, posy).density++;
+   g->m.touch_tile(posx, posy);
+  }
     if (g->m.field_at(posx, posy).type == fd_null)
      g->m.add_field(g, posx, posy, fd_slime, 1);
   else if (g->m.field_at(posx, posy).type == fd_slime &&
-           g->m.field_at(posx, posy).density < 3)
+           g->m.field_at(posx, posy).density < 3) {
    g->m.field_at(posx, posy).density++;
+   g->m.touch_tile(posx, posy);
+  }
  }
 
  if (has_trait(PF_WEB_WEAVER) && one_in(3)) {
   if (g->m.field_at(posx, posy).type == fd_null)
    g->m.add_field(g, posx, posy, fd_web, 1);
   else if (g->m.field_at(posx, posy).type == fd_web &&
-           g->m.field_at(posx, posy).density < 3)
+           g->m.field_at(posx, posy).density < 3) {
    g->m.field_at(posx, posy).density++;
+   g->m.touch_tile(posx, posy);
+  }
  }
 
  if (has_trait(PF_RADIOGENIC) && int(g->turn) % 50 == 0 && radiation >= 10) {
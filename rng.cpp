@@ -1,9 +1,17 @@
 #include "output.h"
 #include "rng.h"
 
+// Each thread has its own, so field jobs running side by side don't share one
+static thread_local rng_stream *cur_stream = NULL;
+
 long rng(long low, long high)
 {
- return low + long((high - low + 1) * double(rand() / double(RAND_MAX + 1.0)));
+ double roll;
+ if (cur_stream != NULL)
+  roll = cur_stream->next() / 4294967296.0;
+ else
+  roll = rand() / double(RAND_MAX + 1.0);
+ return low + long((high - low + 1) * roll);
 }
 
 bool one_in(int chance)
@@ -20,3 +28,26 @@ int dice(int number, int sides)
   ret += rng(1, sides);
  return ret;
 }
+
+rng_stream::rng_stream(unsigned long seed)
+{
+// Scramble the seed, so that neighbouring seeds don't start out alike
+ state = (seed ^ 0x9e3779b9UL) & 0xffffffffUL;
+ if (state == 0)
+  state = 1;	// The one state xorshift never leaves
+ for (int i = 0; i < 4; i++)
+  next();
+}
+
+unsigned long rng_stream::next()
+{
+ state ^= (state << 13) & 0xffffffffUL;
+ state ^= state >> 17;
+ state ^= (state << 5) & 0xffffffffUL;
+ return state;
+}
+
+void use_rng_stream(rng_stream *stream)
+{
+ cur_stream = stream;
+}
@@ -4,4 +4,15 @@
 long rng(long low, long high);
 bool one_in(int chance);
 int dice(int number, int sides);
+
+// A private sequence of random numbers.  While one is in use (see
+// use_rng_stream()), rng(), one_in() and dice() draw from it instead of
+// rand(), so its owner gets the same numbers whatever else drew in between.
+// The stream in use is per thread.
+struct rng_stream {
+ unsigned long state;
+ rng_stream(unsigned long seed = 1);
+ unsigned long next(); // 0 to 2^32 - 1
+};
+void use_rng_stream(rng_stream *stream); // NULL goes back to rand()
 #endif
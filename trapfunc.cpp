@@ -395,7 +395,7 @@ void trapfunc::pit_spikes(game *g, int x, int y)
   g->u.hit(g, hit, side, 0, damage);
   if (one_in(4)) {
    g->add_msg("The spears break!");
-   g->m.ter(x, y) = t_pit;
+   g->m.ter_set(x, y, t_pit);
    g->m.tr_at(x, y) = tr_pit;
    for (int i = 0; i < 4; i++) { // 4 spears to a pit
     if (one_in(3))
@@ -420,7 +420,7 @@ void trapfuncm::pit_spikes(game *g, monster *z, int x, int y)
  if (one_in(4)) {
   if (sees)
    g->add_msg("The spears break!");
-  g->m.ter(x, y) = t_pit;
+  g->m.ter_set(x, y, t_pit);
   g->m.tr_at(x, y) = tr_pit;
   for (int i = 0; i < 4; i++) { // 4 spears to a pit
    if (one_in(3))
@@ -514,32 +514,17 @@ void trapfunc::temple_flood(game *g, int x, int y)
 void trapfunc::temple_toggle(game *g, int x, int y)
 {
  g->add_msg("You hear the grinding of shifting rock.");
- ter_id type = g->m.ter(x, y);
- for (int i = 0; i < SEEX * MAPSIZE; i++) {
-  for (int j = 0; j < SEEY * MAPSIZE; j++) {
-   switch (type) {
-    case t_floor_red:
-     if (g->m.ter(i, j) == t_rock_green)
-      g->m.ter(i, j) = t_floor_green;
-     else if (g->m.ter(i, j) == t_floor_green)
-      g->m.ter(i, j) = t_rock_green;
-     break;
-
-    case t_floor_green:
-     if (g->m.ter(i, j) == t_rock_blue)
-      g->m.ter(i, j) = t_floor_blue;
-     else if (g->m.ter(i, j) == t_floor_blue)
-      g->m.ter(i, j) = t_rock_blue;
-     break;
-
-    case t_floor_blue:
-     if (g->m.ter(i, j) == t_rock_red)
-      g->m.ter(i, j) = t_floor_red;
-     else if (g->m.ter(i, j) == t_floor_red)
-      g->m.ter(i, j) = t_rock_red;
-     break;
-
-   }
-  }
+ ter_id rock, floor;
+ switch (g->m.ter(x, y)) {
+  case t_floor_red:   rock = t_rock_green; floor = t_floor_green; break;
+  case t_floor_green: rock = t_rock_blue;  floor = t_floor_blue;  break;
+  case t_floor_blue:  rock = t_rock_red;   floor = t_floor_red;   break;
+  default: return;
  }
+ std::vector<point> rocks = g->m.find_terrain(rock),
+                    floors = g->m.find_terrain(floor);
+ for (int i = 0; i < rocks.size(); i++)
+  g->m.ter_set(rocks[i].x, rocks[i].y, floor);
+ for (int i = 0; i < floors.size(); i++)
+  g->m.ter_set(floors[i].x, floors[i].y, rock);
 }
@@ -498,7 +498,7 @@ bool vehicle::handle_collision (game *g, int vx, int vy, int part, int x, int y)
                 g->m.ter (x, y) = t_dirt;
                 break;
             case 5:
-                g->m.ter(x, y) = t_rubble;
+                g->m.ter_set(x, y, t_rubble);
                 break;
             case 6:
                 smashed = false;
@@ -566,7 +566,10 @@ bool vehicle::handle_collision (game *g, int vx, int vy, int part, int x, int y)
         {
             if (g->m.field_at(x, y).type == fd_blood &&
                 g->m.field_at(x, y).density < 2)
+            {
                 g->m.field_at(x, y).density++;
+                g->m.touch_tile(x, y);
+            }
             else
                 g->m.add_field(g, x, y, fd_blood, 1);
         }
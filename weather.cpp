@@ -18,15 +18,14 @@ void weather_effect::wet(game *g)
      PLAYER_OUTSIDE && one_in(2))
   g->u.add_morale(MORALE_WET, -1, -30);
 // Put out fires and reduce scent
- for (int x = g->u.posx - SEEX * 2; x <= g->u.posx + SEEX * 2; x++) {
-  for (int y = g->u.posy - SEEY * 2; y <= g->u.posy + SEEY * 2; y++) {
-   if (g->m.is_outside(x, y)) {
-    field *fd = &(g->m.field_at(x, y));
-    if (fd->type == fd_fire)
-     fd->age += 15;
-    if (g->scent(x, y) > 0)
-     g->scent(x, y)--;
-   }
+ for (map_iterator it = g->m.rect(g->u.posx - SEEX * 2, g->u.posy - SEEY * 2,
+                                  g->u.posx + SEEX * 2, g->u.posy + SEEY * 2);
+      !it.done(); it.next()) {
+  if (g->m.is_outside(it.x, it.y)) {
+   if (it.fld().type == fd_fire)
+    it.fld().age += 15;
+   if (g->scent(it.x, it.y) > 0)
+    g->scent(it.x, it.y)--;
   }
  }
 }
@@ -37,15 +36,14 @@ void weather_effect::very_wet(game *g)
      PLAYER_OUTSIDE)
   g->u.add_morale(MORALE_WET, -1, -60);
 // Put out fires and reduce scent
- for (int x = g->u.posx - SEEX * 2; x <= g->u.posx + SEEX * 2; x++) {
-  for (int y = g->u.posy - SEEY * 2; y <= g->u.posy + SEEY * 2; y++) {
-   if (g->m.is_outside(x, y)) {
-    field *fd = &(g->m.field_at(x, y));
-    if (fd->type == fd_fire)
-     fd->age += 45;
-    if (g->scent(x, y) > 0)
-     g->scent(x, y)--;
-   }
+ for (map_iterator it = g->m.rect(g->u.posx - SEEX * 2, g->u.posy - SEEY * 2,
+                                  g->u.posx + SEEX * 2, g->u.posy + SEEY * 2);
+      !it.done(); it.next()) {
+  if (g->m.is_outside(it.x, it.y)) {
+   if (it.fld().type == fd_fire)
+    it.fld().age += 45;
+   if (g->scent(it.x, it.y) > 0)
+    g->scent(it.x, it.y)--;
   }
  }
 }
@@ -66,11 +64,11 @@ void weather_effect::lightning(game *g)
  thunder(g);
  if (one_in(LIGHTNING_CHANCE)) {
   std::vector<point> strike;
-  for (int x = g->u.posx - SEEX * 2; x <= g->u.posx + SEEX * 2; x++) {
-   for (int y = g->u.posy - SEEY * 2; y <= g->u.posy + SEEY * 2; y++) {
-    if (g->m.move_cost(x, y) == 0 && g->m.is_outside(x, y))
-     strike.push_back(point(x, y));
-   }
+  for (map_iterator it = g->m.rect(g->u.posx - SEEX * 2, g->u.posy - SEEY * 2,
+                                   g->u.posx + SEEX * 2, g->u.posy + SEEY * 2);
+       !it.done(); it.next()) {
+   if (g->m.move_cost(it.x, it.y) == 0 && g->m.is_outside(it.x, it.y))
+    strike.push_back(point(it.x, it.y));
   }
   point hit;
   if (strike.size() > 0) {
@@ -110,12 +108,13 @@ void weather_effect::acid(game *g)
   }
  }
  if (g->levz >= 0) {
-  for (int x = g->u.posx - SEEX * 2; x <= g->u.posx + SEEX * 2; x++) {
-   for (int y = g->u.posy - SEEY * 2; y <= g->u.posy + SEEY * 2; y++) {
-    if (!g->m.has_flag(diggable, x, y) && !g->m.has_flag(noitem, x, y) &&
-        g->m.move_cost(x, y) > 0 && g->m.is_outside(x, y) && one_in(400))
-     g->m.add_field(g, x, y, fd_acid, 1);
-   }
+  for (map_iterator it = g->m.rect(g->u.posx - SEEX * 2, g->u.posy - SEEY * 2,
+                                   g->u.posx + SEEX * 2, g->u.posy + SEEY * 2);
+       !it.done(); it.next()) {
+   if (!it.has_flag(diggable) && !it.has_flag(noitem) &&
+       g->m.move_cost(it.x, it.y) > 0 && g->m.is_outside(it.x, it.y) &&
+       one_in(400))
+    g->m.add_field(g, it.x, it.y, fd_acid, 1);
   }
  }
  for (int i = 0; i < g->z.size(); i++) {